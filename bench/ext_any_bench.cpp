@@ -0,0 +1,1036 @@
+// ext_any_bench - micro benchmarks of ext::any<N, Features...> against std::any, std::variant and std::function.
+//
+// Every operation runs over batches of BATCH objects, each batch is timed on its own, and the best and the
+// mean ns/op over all batches are reported.
+// Output is machine readable: csv (default) or json lines, one result per line.
+//
+//   ext_any_bench [--format=csv|json] [--filter=<substring>] [--min-time-ms=<ms>]
+
+#include <ext/any.h>
+#include <ext/any_algorithm.h>
+#include <ext/any_archive.h>
+#include <ext/any_column.h>
+#include <ext/any_flat_map.h>
+#include <ext/any_queue.h>
+#include <ext/any_serialize.h>
+#include <ext/any_shm.h>
+#include <ext/any_sorted.h>
+
+#include <any>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace {
+
+constexpr size_t BATCH{1024};
+
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// heap_payload - too large for any in-place storage used below, so it always lands on the heap.
+struct heap_payload
+{
+    std::array<uint64_t, 10> values{};
+
+    explicit heap_payload(uint64_t v = 0) { values.fill(v); }
+
+    friend bool operator==(const heap_payload&, const heap_payload&) = default;
+    friend auto operator<=>(const heap_payload&, const heap_payload&) = default;
+};
+
+}  // namespace
+
+template<>
+struct std::hash<heap_payload>
+{
+    size_t operator()(const heap_payload& p) const noexcept { return std::hash<uint64_t>{}(p.values[0]); }
+};
+
+namespace {
+
+struct bench_options
+{
+    std::string_view format{"csv"};
+    std::string_view filter{};
+    double           min_time_ms{50.0};
+};
+
+struct bench_result
+{
+    std::string subject;
+    std::string value_kind;
+    std::string operation;
+    size_t      object_size{0};
+    size_t      operations{0};
+    double      best_ns{0};
+    double      mean_ns{0};
+};
+
+class bench_reporter
+{
+public:
+    explicit bench_reporter(const bench_options& options) : _options(options)
+    {
+        if (_options.format == "csv")
+        {
+            std::cout << "subject,value,operation,sizeof,operations,best_ns_per_op,mean_ns_per_op\n";
+        }
+    }
+
+    [[nodiscard]] bool selected(std::string_view subject, std::string_view value_kind, std::string_view op) const
+    {
+        if (_options.filter.empty()) return true;
+        const std::string name{std::string{subject} + '/' + std::string{value_kind} + '/' + std::string{op}};
+        return name.find(_options.filter) != std::string::npos;
+    }
+
+    void report(const bench_result& r) const
+    {
+        if (_options.format == "json")
+        {
+            std::cout << "{\"subject\":\"" << r.subject << "\",\"value\":\"" << r.value_kind << "\",\"operation\":\""
+                      << r.operation << "\",\"sizeof\":" << r.object_size << ",\"operations\":" << r.operations
+                      << ",\"best_ns_per_op\":" << r.best_ns << ",\"mean_ns_per_op\":" << r.mean_ns << "}\n";
+        }
+        else
+        {
+            std::cout << '"' << r.subject << "\"," << r.value_kind << ',' << r.operation << ',' << r.object_size << ','
+                      << r.operations << ',' << r.best_ns << ',' << r.mean_ns << '\n';
+        }
+    }
+
+    [[nodiscard]] double min_time_ms() const { return _options.min_time_ms; }
+
+private:
+    const bench_options& _options;
+};
+
+// raw_objects - uninitialized storage for BATCH objects, so construction can be timed without the destruction.
+template<typename S>
+class raw_objects
+{
+public:
+    raw_objects() = default;
+    raw_objects(const raw_objects&) = delete;
+    raw_objects& operator=(const raw_objects&) = delete;
+    ~raw_objects() { std::allocator<S>{}.deallocate(_objects, BATCH); }
+
+    S&   operator[](size_t i) noexcept { return _objects[i]; }
+    void destroy() noexcept { std::destroy_n(_objects, BATCH); }
+
+private:
+    S* _objects{std::allocator<S>{}.allocate(BATCH)};
+};
+
+// measure - repeat batches until min_time_ms passed, prepare() and finish() are excluded from the timing.
+template<typename Prepare, typename Body, typename Finish>
+void measure(const bench_reporter& reporter, bench_result result, Prepare&& prepare, Body&& body, Finish&& finish)
+{
+    using clock = std::chrono::steady_clock;
+    const auto budget{std::chrono::duration<double, std::milli>(reporter.min_time_ms())};
+
+    double                    best_ns{1e300};
+    std::chrono::nanoseconds  total{0};
+    size_t                    batches{0};
+    const clock::time_point   start{clock::now()};
+    do
+    {
+        prepare();
+        const auto t0{clock::now()};
+        body();
+        const auto t1{clock::now()};
+        finish();
+
+        const auto elapsed{std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0)};
+        total += elapsed;
+        best_ns = std::min(best_ns, static_cast<double>(elapsed.count()) / BATCH);
+        ++batches;
+    } while (clock::now() - start < budget || batches < 3);
+
+    result.operations = batches * BATCH;
+    result.best_ns    = best_ns;
+    result.mean_ns    = static_cast<double>(total.count()) / static_cast<double>(result.operations);
+    reporter.report(result);
+}
+
+// Subject adapters: how to construct, cast, compare and hash each benchmarked type erasure.
+template<typename S>
+struct subject_traits;
+
+template<size_t N, template<typename> class... Features>
+struct subject_traits<ext::any<N, Features...>>
+{
+    using S = ext::any<N, Features...>;
+    static std::string name() { return std::string{ext::src_type_name<S>()}; }
+    template<typename T>
+    static const T& cast(const S& s)
+    {
+        return any_cast<T>(s);
+    }
+};
+
+template<>
+struct subject_traits<std::any>
+{
+    using S = std::any;
+    static std::string name() { return "std::any"; }
+    template<typename T>
+    static const T& cast(const S& s)
+    {
+        return *std::any_cast<T>(&s);
+    }
+};
+
+template<typename... Ts>
+struct subject_traits<std::variant<std::monostate, Ts...>>
+{
+    using S = std::variant<std::monostate, Ts...>;
+    static std::string name() { return "std::variant<monostate, int64, double, heap_payload>"; }
+    template<typename T>
+    static const T& cast(const S& s)
+    {
+        return std::get<T>(s);
+    }
+};
+
+template<typename S>
+constexpr bool has_less_v = requires(const S& a, const S& b) { a < b; };
+template<typename S>
+constexpr bool has_eq_v = requires(const S& a, const S& b) { a == b; };
+template<typename S>
+constexpr bool has_hash_v = ext::is_an_any_v<S> ? requires(const S& a) { a.get_hash(); }
+                                                : requires(const S& a) { std::hash<S>{}(a); };
+
+template<typename S>
+void reset_value(S& s)
+{
+    if constexpr (requires { s.reset(); })
+    {
+        s.reset();
+    }
+    else
+    {
+        s = S{};
+    }
+}
+
+template<typename T>
+T make_value(size_t i)
+{
+    if constexpr (std::is_same_v<T, heap_payload>)
+    {
+        return heap_payload{i};
+    }
+    else
+    {
+        return static_cast<T>(i);
+    }
+}
+
+template<typename S, typename T>
+void bench_subject(const bench_reporter& reporter, std::string_view value_kind)
+{
+    using traits = subject_traits<S>;
+    const std::string subject{traits::name()};
+
+    std::vector<S> sources;
+    sources.reserve(BATCH);
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        sources.emplace_back(make_value<T>(i * 7919 % BATCH));
+    }
+    std::vector<S> targets(sources);
+
+    const auto run = [&](std::string_view op, auto&& prepare, auto&& body, auto&& finish) {
+        if (!reporter.selected(subject, value_kind, op)) return;
+        measure(reporter, bench_result{subject, std::string{value_kind}, std::string{op}, sizeof(S)}, prepare, body,
+                finish);
+    };
+    const auto nothing = [] {};
+
+    raw_objects<S> raw;
+    const T        value{make_value<T>(42)};
+
+    run(
+        "construct", nothing,
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) new (&raw[i]) S(value);
+            do_not_optimize(raw[BATCH - 1]);
+        },
+        [&] { raw.destroy(); });
+
+    run(
+        "copy", nothing,
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) new (&raw[i]) S(sources[i]);
+            do_not_optimize(raw[BATCH - 1]);
+        },
+        [&] { raw.destroy(); });
+
+    std::vector<S> moved_from;
+    run(
+        "move", [&] { moved_from = sources; },
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) new (&raw[i]) S(std::move(moved_from[i]));
+            do_not_optimize(raw[BATCH - 1]);
+        },
+        [&] { raw.destroy(); });
+
+    run(
+        "assign", nothing,
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) targets[i] = sources[i];
+            do_not_optimize(targets[BATCH - 1]);
+        },
+        nothing);
+
+    run(
+        "reset", [&] { targets = sources; },
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) reset_value(targets[i]);
+            do_not_optimize(targets[BATCH - 1]);
+        },
+        nothing);
+
+    run(
+        "any_cast", nothing,
+        [&] {
+            size_t sum{0};
+            for (size_t i{0}; i < BATCH; ++i)
+            {
+                if constexpr (std::is_same_v<T, heap_payload>)
+                    sum += traits::template cast<T>(sources[i]).values[0];
+                else
+                    sum += static_cast<size_t>(traits::template cast<T>(sources[i]));
+            }
+            do_not_optimize(sum);
+        },
+        nothing);
+
+    if constexpr (ext::is_an_any_v<S>)
+    {
+        run(
+            "unchecked_any_cast", nothing,
+            [&] {
+                size_t sum{0};
+                for (size_t i{0}; i < BATCH; ++i)
+                {
+                    if constexpr (std::is_same_v<T, heap_payload>)
+                        sum += unchecked_any_cast<T>(sources[i]).values[0];
+                    else
+                        sum += static_cast<size_t>(unchecked_any_cast<T>(sources[i]));
+                }
+                do_not_optimize(sum);
+            },
+            nothing);
+    }
+    if constexpr (has_less_v<S>)
+    {
+        run(
+            "less", nothing,
+            [&] {
+                size_t count{0};
+                for (size_t i{1}; i < BATCH; ++i) count += sources[i - 1] < sources[i];
+                do_not_optimize(count);
+            },
+            nothing);
+    }
+    if constexpr (has_eq_v<S>)
+    {
+        run(
+            "equal", nothing,
+            [&] {
+                size_t count{0};
+                for (size_t i{1}; i < BATCH; ++i) count += sources[i - 1] == sources[i];
+                do_not_optimize(count);
+            },
+            nothing);
+    }
+    if constexpr (has_hash_v<S>)
+    {
+        run(
+            "get_hash", nothing,
+            [&] {
+                size_t h{0};
+                for (size_t i{0}; i < BATCH; ++i) h ^= std::hash<S>{}(sources[i]);
+                do_not_optimize(h);
+            },
+            nothing);
+    }
+}
+
+// std::function has no value access, only the life cycle operations are comparable.
+template<typename Capture>
+void bench_function(const bench_reporter& reporter, std::string_view value_kind)
+{
+    using S = std::function<uint64_t()>;
+    const std::string subject{"std::function<uint64_t()>"};
+
+    const auto make = [](size_t i) -> S {
+        Capture c{make_value<Capture>(i)};
+        return [c]() -> uint64_t {
+            if constexpr (std::is_same_v<Capture, heap_payload>)
+                return c.values[0];
+            else
+                return static_cast<uint64_t>(c);
+        };
+    };
+    std::vector<S> sources;
+    sources.reserve(BATCH);
+    for (size_t i{0}; i < BATCH; ++i) sources.push_back(make(i));
+    std::vector<S> targets(sources);
+    std::vector<S> moved_from;
+    raw_objects<S> raw;
+
+    const auto run = [&](std::string_view op, auto&& prepare, auto&& body, auto&& finish) {
+        if (!reporter.selected(subject, value_kind, op)) return;
+        measure(reporter, bench_result{subject, std::string{value_kind}, std::string{op}, sizeof(S)}, prepare, body,
+                finish);
+    };
+    const auto nothing = [] {};
+
+    run(
+        "copy", nothing,
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) new (&raw[i]) S(sources[i]);
+            do_not_optimize(raw[BATCH - 1]);
+        },
+        [&] { raw.destroy(); });
+    run(
+        "move", [&] { moved_from = sources; },
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) new (&raw[i]) S(std::move(moved_from[i]));
+            do_not_optimize(raw[BATCH - 1]);
+        },
+        [&] { raw.destroy(); });
+    run(
+        "assign", nothing,
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) targets[i] = sources[i];
+            do_not_optimize(targets[BATCH - 1]);
+        },
+        nothing);
+    run(
+        "reset", [&] { targets = sources; },
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) targets[i] = nullptr;
+            do_not_optimize(targets[BATCH - 1]);
+        },
+        nothing);
+    run(
+        "invoke", nothing,
+        [&] {
+            uint64_t sum{0};
+            for (size_t i{0}; i < BATCH; ++i) sum += sources[i]();
+            do_not_optimize(sum);
+        },
+        nothing);
+}
+
+template<size_t N>
+using bench_any = ext::any<N, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash>;
+using bench_cached_any =
+    ext::any<16, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash, ext::af_cached_hash>;
+using bench_compact_any = ext::any<12, ext::af_compact, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash>;
+using bench_variant_any = ext::any<16, ext::af_variant<int64_t, double, heap_payload>::template types,
+                                   ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash>;
+
+// bench_mixed - hash and count over BATCH anys of three types in random order: per element through the
+//  properties of each value in a std::vector, against the same calls grouped by type with for_each_batched
+//  (partitioning included), and one typed loop per run of an any_column.
+void bench_mixed(const bench_reporter& reporter)
+{
+    using S = bench_any<16>;
+    std::vector<S>        values;
+    ext::any_column<S>    column;
+    const std::string_view value_kind{"mixed_int64_double_heap"};
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        const size_t r{i * 7919 % BATCH};
+        S            value{};
+        switch (r % 3)
+        {
+        case 0: value = S{static_cast<int64_t>(r)}; break;
+        case 1: value = S{static_cast<double>(r)}; break;
+        default: value = S{heap_payload{r}}; break;
+        }
+        values.push_back(value);
+        column.push_back(std::move(value));
+    }
+    const S    probe{int64_t{3}};
+    const auto nothing = [] {};
+
+    const auto run = [&](std::string_view subject, std::string_view op, auto&& body) {
+        if (!reporter.selected(subject, value_kind, op)) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, std::string{op}, sizeof(S)},
+                nothing, body, nothing);
+    };
+    std::vector<size_t> hashes(BATCH);
+    run("std::vector<any<16>>", "get_hash", [&] {
+        for (size_t i{0}; i < BATCH; ++i) hashes[i] = values[i].get_hash();
+        do_not_optimize(hashes[BATCH - 1]);
+    });
+    run("any_column<any<16>>", "get_hash", [&] { do_not_optimize(column.hashes()); });
+    run("for_each_batched<any<16>>", "get_hash", [&] {
+        ext::for_each_batched(values, [&](const auto& batch) {
+            for (size_t k{0}; k < batch.size(); ++k) hashes[batch.index(k)] = batch[k].get_hash();
+        });
+        do_not_optimize(hashes[BATCH - 1]);
+    });
+    run("std::vector<any<16>>", "count", [&] {
+        size_t count{0};
+        for (const auto& v : values) count += v.holds<int64_t>() && v == probe;
+        do_not_optimize(count);
+    });
+    run("any_column<any<16>>", "count", [&] { do_not_optimize(column.count(probe)); });
+}
+
+// bench_flat_map - BATCH keys of three types in an ext::any_flat_map and in a std::unordered_map (any_equal_to, so
+//  keys of different types compare without a throw): build, find of present keys, and find of missing keys.
+template<typename Map>
+void bench_map(const bench_reporter& reporter, std::string_view subject, const std::vector<bench_any<16>>& keys,
+               const std::vector<bench_any<16>>& missing)
+{
+    const std::string_view value_kind{"mixed_int64_double_heap"};
+    const auto             nothing = [] {};
+    const auto run = [&](std::string_view op, auto&& prepare, auto&& body) {
+        if (!reporter.selected(subject, value_kind, op)) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, std::string{op}, sizeof(Map)},
+                prepare, body, nothing);
+    };
+    Map map;
+    run(
+        "build", [&] { map = Map{}; },
+        [&] {
+            for (size_t i{0}; i < BATCH; ++i) map.try_emplace(keys[i], static_cast<int>(i));
+        });
+    map = Map{};
+    for (size_t i{0}; i < BATCH; ++i) map.try_emplace(keys[i], static_cast<int>(i));
+    run("find_hit", nothing, [&] {
+        int sum{0};
+        for (const auto& k : keys) sum += map.find(k)->second;
+        do_not_optimize(sum);
+    });
+    run("find_miss", nothing, [&] {
+        size_t found{0};
+        for (const auto& k : missing) found += map.find(k) != map.end();
+        do_not_optimize(found);
+    });
+}
+
+void bench_flat_map(const bench_reporter& reporter)
+{
+    using S = bench_any<16>;
+    std::vector<S> keys;
+    std::vector<S> missing;
+    for (size_t i{0}; i < 2 * BATCH; ++i)
+    {
+        const size_t r{i * 7919 % (2 * BATCH)};
+        S            key{};
+        switch (r % 3)
+        {
+        case 0: key = S{static_cast<int64_t>(r)}; break;
+        case 1: key = S{static_cast<double>(r)}; break;
+        default: key = S{heap_payload{r}}; break;
+        }
+        (i < BATCH ? keys : missing).push_back(std::move(key));
+    }
+    bench_map<ext::any_flat_map<S, int>>(reporter, "ext::any_flat_map<any<16>>", keys, missing);
+    bench_map<std::unordered_map<S, int, std::hash<S>, ext::any_equal_to<S>>>(reporter, "std::unordered_map<any<16>>",
+                                                                             keys, missing);
+
+    // sorted tables, built once and searched: one key at a time, and the whole batch with find_n.
+    std::vector<std::pair<S, int>> items;
+    for (size_t i{0}; i < BATCH; ++i) items.emplace_back(keys[i], static_cast<int>(i));
+    const std::map<S, int, ext::any_less<S>> tree(items.begin(), items.end());
+    const ext::any_sorted_map<S, int>        sorted{items};
+    const std::string_view                   value_kind{"mixed_int64_double_heap"};
+    const auto                               nothing = [] {};
+    const auto run = [&](std::string_view subject, std::string_view op, size_t object_size, auto&& body) {
+        if (!reporter.selected(subject, value_kind, op)) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, std::string{op}, object_size},
+                nothing, body, nothing);
+    };
+    run("std::map<any<16>>", "find_hit", sizeof(tree), [&] {
+        int sum{0};
+        for (const auto& k : keys) sum += tree.find(k)->second;
+        do_not_optimize(sum);
+    });
+    run("ext::any_sorted_map<any<16>>", "find_hit", sizeof(sorted), [&] {
+        int sum{0};
+        for (const auto& k : keys) sum += *sorted.find(k);
+        do_not_optimize(sum);
+    });
+    run("ext::any_sorted_map<any<16>>", "find_n_hit", sizeof(sorted), [&] { do_not_optimize(sorted.find_n(keys)); });
+}
+
+// bench_sort - std::sort then std::unique of BATCH anys of three types in random order, with the non throwing
+//  any_less / any_equal_to over af_strict_less and af_strict_eq, against the operator<=> of af_three_way.
+template<typename S, typename Less, typename Equal>
+void bench_sort_subject(const bench_reporter& reporter, std::string_view subject, Less less, Equal equal)
+{
+    const std::string_view value_kind{"mixed_int64_double_heap"};
+    if (!reporter.selected(subject, value_kind, "sort_unique")) return;
+    std::vector<S> values;
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        const size_t r{i * 7919 % BATCH % 400};  // with duplicates
+        switch (r % 3)
+        {
+        case 0: values.emplace_back(static_cast<int64_t>(r)); break;
+        case 1: values.emplace_back(static_cast<double>(r)); break;
+        default: values.emplace_back(heap_payload{r}); break;
+        }
+    }
+    std::vector<S> work;
+    measure(
+        reporter, bench_result{std::string{subject}, std::string{value_kind}, "sort_unique", sizeof(S)},
+        [&] { work = values; },
+        [&] {
+            std::sort(work.begin(), work.end(), less);
+            do_not_optimize(std::unique(work.begin(), work.end(), equal));
+        },
+        [] {});
+}
+
+void bench_sort(const bench_reporter& reporter)
+{
+    using SL = ext::any<16, ext::af_strict_less, ext::af_strict_eq>;
+    using TW = ext::any<16, ext::af_three_way>;
+    bench_sort_subject<SL>(reporter, "any<16,strict_less,strict_eq>", ext::any_less<SL>{}, ext::any_equal_to<SL>{});
+    bench_sort_subject<TW>(reporter, "any<16,three_way>", std::less<>{}, std::equal_to<>{});
+}
+
+// bench_format - BATCH int64 and double values written as text: operator<< of af_streamed to a std::ostringstream,
+//  against to_chars of af_to_chars and std::format_to of af_formatted into a preallocated buffer.
+void bench_format(const bench_reporter& reporter)
+{
+#if defined(__cpp_lib_format)
+    using S = ext::any<16, ext::af_streamed, ext::af_to_chars, ext::af_formatted>;
+#else
+    using S = ext::any<16, ext::af_streamed, ext::af_to_chars>;
+#endif
+    const std::string_view value_kind{"mixed_int64_double"};
+    std::vector<S>         values;
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        if (i % 2) values.emplace_back(static_cast<int64_t>(i * 7919));
+        else values.emplace_back(static_cast<double>(i) / 7);
+    }
+    const auto        nothing = [] {};
+    std::vector<char> buffer(BATCH * 32);
+    const auto run = [&](std::string_view subject, auto&& prepare, auto&& body) {
+        if (!reporter.selected(subject, value_kind, "write_text")) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, "write_text", sizeof(S)},
+                prepare, body, nothing);
+    };
+
+    std::ostringstream os;
+    run("any<16,streamed>", [&] { os.str({}); },
+        [&] {
+            for (const auto& v : values) os << v << ' ';
+        });
+    run("any<16,to_chars>", nothing, [&] {
+        char* out{buffer.data()};
+        char* last{buffer.data() + buffer.size()};
+        for (const auto& v : values)
+        {
+            out    = to_chars(out, last, v).ptr;
+            *out++ = ' ';
+        }
+        do_not_optimize(out);
+    });
+#if defined(__cpp_lib_format)
+    run("any<16,formatted>", nothing, [&] {
+        char* out{buffer.data()};
+        for (const auto& v : values) out = std::format_to(out, "{} ", v);
+        do_not_optimize(out);
+    });
+#endif
+}
+
+// bench_serialize - BATCH int64, double and short string values recorded and replayed: af_serialize binary records
+//  read back through an any_registry, against tagged text written with operator<< and parsed with operator>>.
+void bench_serialize(const bench_reporter& reporter)
+{
+    using R = ext::any<16, ext::af_serialize>;
+    const std::string_view value_kind{"mixed_int64_double_string"};
+    std::vector<R>         values;
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        if (i % 3 == 0) values.emplace_back(static_cast<int64_t>(i * 7919));
+        else if (i % 3 == 1) values.emplace_back(static_cast<double>(i) / 7);
+        else values.emplace_back(std::to_string(i * 13));
+    }
+    const auto nothing = [] {};
+    const auto run     = [&](std::string_view subject, std::string_view operation, auto&& prepare, auto&& body) {
+        if (!reporter.selected(subject, value_kind, operation)) return;
+        const bench_result result{std::string{subject}, std::string{value_kind}, std::string{operation}, sizeof(R)};
+        measure(reporter, result, prepare, body, nothing);
+    };
+
+    ext::any_registry<R> registry;
+    registry.add<int64_t, double, std::string>();
+    std::vector<std::byte> records;
+    std::vector<R>         replay;
+    replay.reserve(BATCH);
+    run("any<16,serialize>", "record", [&] { records.clear(); }, [&] { ext::serialize_all(values, records); });
+    run("any<16,serialize>", "replay", [&] { replay.clear(); },
+        [&] {
+            registry.read_all(records, replay);
+            do_not_optimize(replay.data());
+        });
+
+    std::ostringstream os;
+    const auto         write_text = [&] {
+        for (const auto& v : values)
+        {
+            if (v.holds<int64_t>()) os << "i " << any_cast<int64_t>(v) << ' ';
+            else if (v.holds<double>()) os << "d " << any_cast<double>(v) << ' ';
+            else os << "s " << any_cast<std::string>(v) << ' ';
+        }
+    };
+    run("text_stream", "record", [&] { os.str({}); }, write_text);
+    os.str({});
+    write_text();
+    const std::string  text{os.str()};
+    std::istringstream is;
+    run("text_stream", "replay",
+        [&] {
+            replay.clear();
+            is.clear();
+            is.str(text);
+        },
+        [&] {
+            char tag{};
+            while (is >> tag)
+            {
+                if (tag == 'i')
+                {
+                    int64_t v{};
+                    is >> v;
+                    replay.emplace_back(v);
+                }
+                else if (tag == 'd')
+                {
+                    double v{};
+                    is >> v;
+                    replay.emplace_back(v);
+                }
+                else
+                {
+                    std::string v;
+                    is >> v;
+                    replay.emplace_back(std::move(v));
+                }
+            }
+            do_not_optimize(replay.data());
+        });
+}
+
+// bench_archive - a snapshot of BATCH int64 and double values opened and summed: any_archive_view reading the values
+//  in place, against af_serialize records read back with read_all into anys.
+void bench_archive(const bench_reporter& reporter)
+{
+    using R = ext::any<16, ext::af_serialize>;
+    const std::string_view value_kind{"mixed_int64_double"};
+    std::vector<R>         values;
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        if (i % 2) values.emplace_back(static_cast<int64_t>(i * 7919));
+        else values.emplace_back(static_cast<double>(i) / 7);
+    }
+    ext::any_registry<R> registry;
+    registry.add<int64_t, double>();
+
+    std::ostringstream os;
+    ext::write_archive(os, values);
+    const std::string      text{os.str()};
+    std::vector<std::byte> archive(text.size());
+    std::memcpy(archive.data(), text.data(), text.size());
+    std::vector<std::byte> records;
+    ext::serialize_all(values, records);
+
+    const auto nothing = [] {};
+    const auto run     = [&](std::string_view subject, auto&& prepare, auto&& body) {
+        if (!reporter.selected(subject, value_kind, "open_sum")) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, "open_sum", sizeof(R)}, prepare,
+                body, nothing);
+    };
+    run("any_archive_view", nothing, [&] {
+        const ext::any_archive_view<R> view{archive, registry};
+        double                         sum{0};
+        for (size_t i{0}; i < view.size(); ++i)
+        {
+            const auto r{view[i]};
+            if (const auto* d{r.get_if<double>()}) sum += *d;
+            else if (const auto* n{r.get_if<int64_t>()}) sum += static_cast<double>(*n);
+        }
+        do_not_optimize(sum);
+    });
+    std::vector<R> replay;
+    replay.reserve(BATCH);
+    run("any<16,serialize>", [&] { replay.clear(); }, [&] {
+        registry.read_all(records, replay);
+        double sum{0};
+        for (const auto& a : replay)
+        {
+            if (a.holds<double>()) sum += any_cast<double>(a);
+            else if (a.holds<int64_t>()) sum += static_cast<double>(any_cast<int64_t>(a));
+        }
+        do_not_optimize(sum);
+    });
+}
+
+// bench_shm_ring - BATCH int64 and double values passed through an any_shm_ring, pushed then consumed on one thread:
+//  read in place with try_consume, or rehydrated into anys with try_pop.
+void bench_shm_ring(const bench_reporter& reporter)
+{
+    using R = ext::any<16, ext::af_serialize>;
+    const std::string_view value_kind{"mixed_int64_double"};
+    std::vector<R>         values;
+    for (size_t i{0}; i < BATCH; ++i)
+    {
+        if (i % 2) values.emplace_back(static_cast<int64_t>(i * 7919));
+        else values.emplace_back(static_cast<double>(i) / 7);
+    }
+    ext::any_registry<R> registry;
+    registry.add<int64_t, double>();
+    std::vector<std::byte> memory(ext::any_shm_ring<R>::segment_size(BATCH * 32) + 64);
+    const std::span<std::byte> aligned{
+        std::span{memory}.subspan((64 - reinterpret_cast<uintptr_t>(memory.data()) % 64) % 64)};
+    auto producer{ext::any_shm_ring<R>::create(aligned, registry)};
+    auto consumer{ext::any_shm_ring<R>::attach(aligned, registry)};
+
+    const auto nothing = [] {};
+    const auto run     = [&](std::string_view subject, auto&& body) {
+        if (!reporter.selected(subject, value_kind, "push_pop")) return;
+        measure(reporter, bench_result{std::string{subject}, std::string{value_kind}, "push_pop", sizeof(R)}, nothing,
+                body, nothing);
+    };
+    run("any_shm_ring,consume", [&] {
+        for (const auto& v : values) producer.try_push(v);
+        double sum{0};
+        while (consumer.try_consume([&](const ext::any_record_ref<R>& r) {
+            if (const auto* d{r.get_if<double>()}) sum += *d;
+            else if (const auto* n{r.get_if<int64_t>()}) sum += static_cast<double>(*n);
+        }))
+        {
+        }
+        do_not_optimize(sum);
+    });
+    run("any_shm_ring,pop", [&] {
+        for (const auto& v : values) producer.try_push(v);
+        double sum{0};
+        R      out;
+        while (consumer.try_pop(out))
+        {
+            if (out.holds<double>()) sum += any_cast<double>(out);
+            else if (out.holds<int64_t>()) sum += static_cast<double>(any_cast<int64_t>(out));
+        }
+        do_not_optimize(sum);
+    });
+}
+
+// mutex_queue - the baseline of the queue benchmarks: a std::deque of anys under a std::mutex.
+template<typename A>
+class mutex_queue
+{
+public:
+    explicit mutex_queue(size_t /*capacity, unbounded*/) {}
+
+    template<typename T, typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        std::lock_guard lock{_mutex};
+        _queue.emplace_back().template emplace<T>(std::forward<Args>(args)...);
+        return true;
+    }
+    bool try_pop(A& out)
+    {
+        std::lock_guard lock{_mutex};
+        if (_queue.empty()) return false;
+        out = std::move(_queue.front());
+        _queue.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex    _mutex;
+    std::deque<A> _queue;
+};
+
+// bench_queue_subject - BATCH any<48> messages of 40 bytes (in place) between two threads:
+//      transfer  - pushed by this thread, popped by a consumer thread, throughput.
+//      ping_pong - pushed, popped and pushed back by an echo thread, popped here, the round trip latency.
+//  A side which finds the queue full or empty yields: the numbers do not assume a free core per thread.
+template<typename Q>
+void bench_queue_subject(const bench_reporter& reporter, std::string_view subject)
+{
+    using M       = ext::any<48>;
+    using payload = std::array<int64_t, 5>;
+    const std::string_view value_kind{"inplace_payload40"};
+    const auto             nothing = [] {};
+    const auto             wait    = [] { std::this_thread::yield(); };
+    const auto             result  = [&](std::string_view operation) {
+        return bench_result{std::string{subject}, std::string{value_kind}, std::string{operation}, sizeof(M)};
+    };
+
+    if (reporter.selected(subject, value_kind, "transfer"))
+    {
+        Q                   q{BATCH};
+        std::atomic<bool>   stop{false};
+        std::atomic<size_t> consumed{0};
+        std::thread         consumer{[&] {
+            M      m;
+            size_t n{0};
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (q.try_pop(m)) consumed.store(++n, std::memory_order_release);
+                else wait();
+            }
+        }};
+        size_t target{0};
+        measure(reporter, result("transfer"), nothing, [&] {
+            for (size_t i{0}; i < BATCH; ++i)
+            {
+                while (!q.template try_emplace<payload>(payload{static_cast<int64_t>(i)})) wait();
+            }
+            target += BATCH;
+            while (consumed.load(std::memory_order_acquire) < target) wait();
+        }, nothing);
+        stop = true;
+        consumer.join();
+    }
+    if (reporter.selected(subject, value_kind, "ping_pong"))
+    {
+        Q                 ping{16};
+        Q                 pong{16};
+        std::atomic<bool> stop{false};
+        std::thread       echo{[&] {
+            M m;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (!ping.try_pop(m))
+                {
+                    wait();
+                    continue;
+                }
+                while (!pong.template try_emplace<payload>(any_cast<payload>(m))) wait();
+            }
+        }};
+        M back;
+        measure(reporter, result("ping_pong"), nothing, [&] {
+            for (size_t i{0}; i < BATCH; ++i)
+            {
+                while (!ping.template try_emplace<payload>(payload{static_cast<int64_t>(i)})) wait();
+                while (!pong.try_pop(back)) wait();
+            }
+            do_not_optimize(back);
+        }, nothing);
+        stop = true;
+        echo.join();
+    }
+}
+
+void bench_queue(const bench_reporter& reporter)
+{
+    using M = ext::any<48>;
+    bench_queue_subject<ext::any_spsc_queue<M>>(reporter, "any_spsc_queue");
+    bench_queue_subject<ext::any_mpmc_queue<M>>(reporter, "any_mpmc_queue");
+    bench_queue_subject<mutex_queue<M>>(reporter, "mutex_deque");
+}
+
+template<typename T>
+void bench_all_subjects(const bench_reporter& reporter, std::string_view value_kind)
+{
+    bench_subject<bench_any<8>, T>(reporter, value_kind);
+    bench_subject<bench_any<16>, T>(reporter, value_kind);
+    bench_subject<bench_any<24>, T>(reporter, value_kind);
+    bench_subject<bench_any<32>, T>(reporter, value_kind);
+    bench_subject<bench_any<48>, T>(reporter, value_kind);
+    bench_subject<bench_any<64>, T>(reporter, value_kind);
+    bench_subject<ext::any<16>, T>(reporter, value_kind);
+    bench_subject<ext::any<16, ext::af_pooled>, T>(reporter, value_kind);
+    bench_subject<bench_cached_any, T>(reporter, value_kind);
+    bench_subject<bench_compact_any, T>(reporter, value_kind);
+    bench_subject<bench_variant_any, T>(reporter, value_kind);
+    bench_subject<std::any, T>(reporter, value_kind);
+    bench_subject<std::variant<std::monostate, int64_t, double, heap_payload>, T>(reporter, value_kind);
+}
+
+bench_options parse_options(int argc, char* argv[])
+{
+    bench_options options{};
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg.starts_with("--format="))
+        {
+            options.format = arg.substr(9);
+        }
+        else if (arg.starts_with("--filter="))
+        {
+            options.filter = arg.substr(9);
+        }
+        else if (arg.starts_with("--min-time-ms="))
+        {
+            options.min_time_ms = std::strtod(std::string{arg.substr(14)}.c_str(), nullptr);
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--format=csv|json] [--filter=<substring>] [--min-time-ms=<ms>]\n";
+            std::exit(1);
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const bench_options  options{parse_options(argc, argv)};
+    const bench_reporter reporter{options};
+
+    bench_all_subjects<int64_t>(reporter, "inplace_int64");
+    bench_all_subjects<double>(reporter, "inplace_double");
+    bench_all_subjects<heap_payload>(reporter, "heap_payload80");
+
+    bench_function<int64_t>(reporter, "inplace_int64");
+    bench_function<heap_payload>(reporter, "heap_payload80");
+
+    bench_mixed(reporter);
+    bench_flat_map(reporter);
+    bench_sort(reporter);
+    bench_format(reporter);
+    bench_serialize(reporter);
+    bench_archive(reporter);
+    bench_shm_ring(reporter);
+    bench_queue(reporter);
+    return 0;
+}
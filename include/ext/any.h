@@ -8,6 +8,12 @@
 
 #include <algorithm>
 #include <any>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <compare>
+#include <concepts>
 #include <cstdint>
 #include <cstring>
 #include <format>
@@ -15,7 +21,11 @@
 #include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <typeindex>
 #include <utility>
@@ -93,6 +103,87 @@ constexpr size_t required_size()
     }
 }
 
+// reserved_size - the bytes a Feature keeps at the end of the storage for itself, not available to the value.
+template<typename T>
+constexpr size_t reserved_size()
+{
+    if constexpr (requires { T::reserved_storage_size(); })
+    {
+        return T::reserved_storage_size();
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+// heap_allocator_feature - the first Feature providing heap_allocate<T>() / heap_deallocate<T>(T*), or void.
+// Values that do not fit in place are allocated through it, see af_allocator<Alloc>.
+template<typename F>
+constexpr bool is_heap_allocator_v{requires(int* p) {
+    { F::template heap_allocate<int>() } -> std::same_as<int*>;
+    F::template heap_deallocate<int>(p);
+}};
+
+template<typename... Fs>
+struct heap_allocator_feature
+{
+    using type = void;
+};
+template<typename F, typename... Fs>
+struct heap_allocator_feature<F, Fs...>
+{
+    using type = std::conditional_t<is_heap_allocator_v<F>, F, typename heap_allocator_feature<Fs...>::type>;
+};
+
+// closed_types_of - the std::tuple<Ts...> of the first Feature declaring a closed set of value types
+//  (closed_types, see af_variant), or std::tuple<> when the value type is open.
+template<typename F>
+constexpr bool has_closed_types_v{requires { typename F::closed_types; }};
+
+template<typename F>
+struct feature_closed_types
+{
+    using type = std::tuple<>;
+};
+template<typename F>
+    requires has_closed_types_v<F>
+struct feature_closed_types<F>
+{
+    using type = typename F::closed_types;
+};
+
+template<typename... Fs>
+struct closed_types_of
+{
+    using type = std::tuple<>;
+};
+template<typename F, typename... Fs>
+struct closed_types_of<F, Fs...>
+{
+    using type = std::conditional_t<has_closed_types_v<F>, typename feature_closed_types<F>::type,
+                                    typename closed_types_of<Fs...>::type>;
+};
+
+// is_compact_layout_v - the Feature selects the compact layout, see af_compact.
+template<typename F>
+constexpr bool is_compact_layout_v{requires { requires F::compact_layout; }};
+
+// cold_properties_of - a Feature's extend_cold_properties, or a distinct empty struct when it has none.
+template<typename F>
+struct cold_properties_of
+{
+    struct type
+    {
+    };
+};
+template<typename F>
+    requires requires { typename F::extend_cold_properties; }
+struct cold_properties_of<F>
+{
+    using type = typename F::extend_cold_properties;
+};
+
 template<size_t N = 16, template<typename> class... Features>
 class any final : public Features<any<N, Features...>>...
 {
@@ -103,66 +194,143 @@ public:
     {
         if constexpr (sizeof...(Features) > 0)
         {
-            return std::max({N, required_size<Features<A>>()...});
+            return std::max({N, required_size<Features<A>>()...}) + reserved_storage_size();
         }
         return N;
     }
 
-    class alignas(64) any_properties final : public Features<A>::extend_properties...
+    // reserved_storage_size - the tail of _storage kept by the Features (e.g. af_cached_hash), after the value.
+    constexpr static size_t reserved_storage_size() noexcept
+    {
+        return (size_t{0} + ... + reserved_size<Features<A>>());
+    }
+    constexpr static size_t value_storage_size() noexcept { return storage_size() - reserved_storage_size(); }
+
+    using heap_allocator = typename heap_allocator_feature<Features<A>...>::type;
+    static_assert((0 + ... + static_cast<int>(is_heap_allocator_v<Features<A>>)) <= 1,
+                  "only one heap allocator feature per ext::any");
+
+    // compact - af_compact: the tag word is a 32 bit index into the registry of the value types of this any
+    //  type, after _storage, instead of the properties pointer.
+    constexpr static bool compact{(false || ... || is_compact_layout_v<Features<A>>)};
+    using tag_word = std::conditional_t<compact, uint32_t, uintptr_t>;
+
+    // closed_types - the value types of an any with a closed type set (af_variant), std::tuple<> otherwise.
+    //  With up to max_closed_types types the 1 based index of the value type is kept in the tag bits of the
+    //  properties pointer (closed_dispatch), and the life cycle and Features operations switch on it.
+    using closed_types = typename closed_types_of<Features<A>...>::type;
+    static_assert((0 + ... + static_cast<int>(has_closed_types_v<Features<A>>)) <= 1,
+                  "only one closed type set feature per ext::any");
+
+    template<size_t I>
+    using closed_type = std::tuple_element_t<I, closed_types>;
+
+    constexpr static size_t closed_type_count() noexcept { return std::tuple_size_v<closed_types>; }
+    constexpr static size_t max_closed_types{15};
+    constexpr static bool   closed_dispatch{closed_type_count() > 0 && closed_type_count() <= max_closed_types};
+
+    // index_of<T> - the 1 based index of T in closed_types, 0 when T is not one of them.
+    template<typename T>
+    constexpr static size_t index_of() noexcept
+    {
+        return []<size_t... Is>(std::index_sequence<Is...>) {
+            return (size_t{0} + ... + (std::is_same_v<T, closed_type<Is>> ? Is + 1 : 0));
+        }(std::make_index_sequence<closed_type_count()>{});
+    }
+
+    // any_properties_cold - type metadata and the dispatch that is not on the hot path (diagnostics, streams,
+    //  same type assignment), reached through any_properties::_cold. Features add to it with extend_cold_properties.
+    class any_properties_cold final : public cold_properties_of<Features<A>>::type...
     {
     public:
         bool _inplace_flag{false};  // Is SOO active for this type?
         bool _is_move_constructible{false};
         bool _is_copy_constructible{false};
+        // The _storage representation of the value: copied with memcpy, not destroyed, relocated with memcpy.
+        //  Only in place trivially copyable values are trivially copyable and destructible, heap stored values are
+        //  always trivially relocatable (the pointer moves).
+        bool _is_trivially_copyable{false};
+        bool _is_trivially_destructible{false};
+        bool _is_trivially_relocatable{false};
 #ifdef ANY_RTTI_ON
         const std::type_info* _type_info{&typeid(void)};
-        std::type_index       _type_index{std::type_index(typeid(void))};
 #endif
         std::string_view _src_type_name{""};
         size_t           _value_size{0};
+        uint64_t         _fingerprint{0};  // type_fingerprint<T>()
 
         void (*_destroy)(A&){nullptr};
-        void (*_delete)(A&){nullptr};
+        // _clone - the copy of a value which is not trivial: its copy constructor (an allocation for the heap
+        //  stored values) costs more than the load of the cold block.
         void (*_clone)(A&, const A&){nullptr};
-        void (*_move)(A&, A&&){nullptr};
         void (*_assign_clone)(A&, const A&){nullptr};
         void (*_assign_move)(A&, void*){nullptr};
+        // _reset_n - destroys n values of this type and empties the anys, one call for a run (see any_column).
+        void (*_reset_n)(A*, size_t){nullptr};
+    };
+
+    // any_properties - the per type dispatch table, everything here is used on the hot path and must fit the
+    //  first cache line: the Features' extend_properties (compare, hash, ...) then the life cycle operations.
+    //  _move, _delete and _cold leave room for five Features pointers.
+    class alignas(64) any_properties final : public Features<A>::extend_properties...
+    {
+    public:
+        void (*_move)(A&, A&&){nullptr};
+        void (*_delete)(A&){nullptr};
+
+        const any_properties_cold* _cold{nullptr};
 
         friend std::ostream& operator<<(std::ostream& os, const any_properties& prop)
         {
+            const any_properties_cold& cold{*prop._cold};
             // clang-format off
             return os << "\nAny: " << ext::src_type_name<A>()
                << "\n   any::operations<>:" << (void *) &prop
-               << "\n   type name: " << prop._src_type_name
+               << "\n   type name: " << cold._src_type_name
+               << "\n   fingerprint: " << cold._fingerprint
 #ifdef ANY_RTTI_ON
-               << "\n   typeinfo name: " << prop._type_info->name()
-               << "\n   type_index hash: " << prop._type_index.hash_code() // std::type_index(prop._type_info)
+               << "\n   typeinfo name: " << cold._type_info->name()
+               << "\n   type_index hash: " << std::type_index(*cold._type_info).hash_code()
 #endif
-               << "\n   value size: " << prop._value_size
-               << "\n   inplace: " << prop._inplace_flag
-               << "\n   move constructible: " << prop._is_move_constructible
-               << "\n   copy constructible: " << prop._is_copy_constructible
+               << "\n   value size: " << cold._value_size
+               << "\n   inplace: " << cold._inplace_flag
+               << "\n   move constructible: " << cold._is_move_constructible
+               << "\n   copy constructible: " << cold._is_copy_constructible
+               << "\n   trivially copyable: " << cold._is_trivially_copyable
+               << "\n   trivially destructible: " << cold._is_trivially_destructible
+               << "\n   trivially relocatable: " << cold._is_trivially_relocatable
                << "\n--\n";
             // clang-format on
         }
     };
+    static_assert(sizeof(any_properties) == 64,
+                  "the hot dispatch pointers of the Features do not fit in one cache line, "
+                  "move some of them to extend_cold_properties");
     friend class any_properties;
 
 public:
+    // The pointer to a heap stored value is kept in the first bytes of _storage.
     template<typename T>
     T* get_pointer()
     {
-        return std::bit_cast<T*>(_pointer);
+        static_assert(sizeof(_storage) >= sizeof(void*), "_storage too small for a pointer, values must be in place");
+        T* p;
+        std::memcpy(&p, &_storage, sizeof(p));
+        return p;
     }
     template<typename T>
     const T* get_pointer() const
     {
-        return std::bit_cast<const T*>(_pointer);
+        static_assert(sizeof(_storage) >= sizeof(void*), "_storage too small for a pointer, values must be in place");
+        const T* p;
+        std::memcpy(&p, &_storage, sizeof(p));
+        return p;
     }
     template<typename T>
     void set_pointer(T* value)
     {
-        _pointer = std::bit_cast<void*>(value);
+        static_assert(sizeof(_storage) >= sizeof(void*), "_storage too small for a pointer, values must be in place");
+        std::memcpy(&_storage, &value, sizeof(value));
     }
 
     template<typename T>
@@ -179,18 +347,62 @@ public:
     template<typename T>
     T& storage_dynamic() noexcept
     {
-        return *std::bit_cast<T*>(_pointer);
+        return *get_pointer<T>();
     }
     template<typename T>
     const T& storage_dynamic() const noexcept
     {
-        return *std::bit_cast<const T*>(_pointer);
+        return *get_pointer<T>();
+    }
+
+    // heap_new / heap_delete - allocation of values that are not stored in place, through heap_allocator when set.
+    template<typename T, typename... Args>
+    static T* heap_new(Args&&... args)
+    {
+        if constexpr (std::is_void_v<heap_allocator>)
+        {
+            return new T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            T* p{heap_allocator::template heap_allocate<T>()};
+            try
+            {
+                return std::construct_at(p, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                heap_allocator::template heap_deallocate<T>(p);
+                throw;
+            }
+        }
+    }
+
+    template<typename T>
+    static void heap_delete(T* p) noexcept
+    {
+        if constexpr (std::is_void_v<heap_allocator>)
+        {
+            delete p;
+        }
+        else
+        {
+            std::destroy_at(p);
+            heap_allocator::template heap_deallocate<T>(p);
+        }
     }
 
     template<typename T>
     constexpr static bool is_inplace() noexcept
     {
-        return sizeof(T) <= storage_size() && alignof(T) <= alignof(A);
+        return sizeof(T) <= value_storage_size() && alignof(T) <= alignof(A);
+    }
+
+    // is_trivial - in place and trivially copyable, the value is copied and relocated with memcpy, not destroyed.
+    template<typename T>
+    constexpr static bool is_trivial() noexcept
+    {
+        return is_inplace<T>() && std::is_trivially_copyable_v<T> && std::is_copy_constructible_v<T>;
     }
 
     template<typename T>
@@ -233,37 +445,130 @@ public:
         }
     }
 
+    // The properties pointer is kept with tag bits in its low bits (any_properties is 64 bytes aligned),
+    //  so an any is classified without loading its properties. Empty is the all zero word.
+    //  With the compact layout the same tag bits are below the registry index (compact_index_shift).
+    static constexpr uintptr_t inplace_tag{1};  // the value is stored in _storage.
+    static constexpr uintptr_t trivial_tag{2};  // is_trivial<T>(): memcpy copy and relocation, no destructor.
+    static constexpr uintptr_t type_index_shift{2};   // bits 2..5: index_of<T>() when closed_dispatch, else 0.
+    static constexpr uintptr_t type_index_mask{60};
+    static constexpr uintptr_t tags_mask{63};
+    static constexpr uintptr_t compact_index_shift{6};
+    static_assert(max_closed_types == (type_index_mask >> type_index_shift), "type index does not fit the tag bits");
+
+    template<typename T>
+    static constexpr uintptr_t type_tags() noexcept
+    {
+        return (is_inplace<T>() ? inplace_tag : 0) | (is_trivial<T>() ? trivial_tag : 0) |
+               (closed_dispatch ? index_of<T>() << type_index_shift : 0);
+    }
+
+    // tagged_properties<T> - the tag word of the anys holding a T. With the compact layout T is registered on its
+    //  first use, which throws std::length_error past max_compact_types, then it is one load, no guard.
+    template<typename T>
+    static tag_word tagged_properties() noexcept(!compact)
+    {
+        if constexpr (compact)
+        {
+            const tag_word word{_compact_word<T>.load(std::memory_order_acquire)};
+            return word ? word : register_compact<T>();
+        }
+        else
+        {
+            return std::bit_cast<uintptr_t>(&any_properties_t_data_type<T, A>::instance) | type_tags<T>();
+        }
+    }
+
+    // known_tagged_properties<T> - tagged_properties<T>() without the registration: with the compact layout 0 while
+    //  T is not registered, no any holds a T yet.
+    template<typename T>
+    static tag_word known_tagged_properties() noexcept
+    {
+        if constexpr (compact)
+        {
+            return _compact_word<T>.load(std::memory_order_acquire);
+        }
+        else
+        {
+            return tagged_properties<T>();
+        }
+    }
+
+    // properties_of<T> - the properties of the anys holding a T, a.properties() == properties_of<T>() is holds<T>().
+    template<typename T>
+    static constexpr const any_properties* properties_of() noexcept
+    {
+        return &any_properties_t_data_type<std::decay_t<T>, A>::instance;
+    }
+
+    // The registry of the compact layout, index 0 is the empty any. Written under the mutex, a slot is read only
+    //  by an any holding its index, which was published by the release store of _compact_word<T>.
+    constexpr static size_t max_compact_types{4096};
+
+private:
+    static inline const any_properties* _compact_registry[compact ? max_compact_types : 1]{};
+    static inline size_t                _compact_registered{1};
+    static inline std::mutex            _compact_mutex;
+
+    // _compact_word<T> - the tag word of T with the compact layout, 0 until T is registered.
+    template<typename T>
+    static inline constinit std::atomic<tag_word> _compact_word{0};
+
+    template<typename T>
+    static tag_word register_compact()
+    {
+        std::lock_guard lock{_compact_mutex};
+        tag_word        word{_compact_word<T>.load(std::memory_order_relaxed)};
+        if (word == 0)  // else registered by another thread meanwhile
+        {
+            if (_compact_registered == max_compact_types)
+            {
+                throw std::length_error("ext::any compact layout: too many value types");
+            }
+            _compact_registry[_compact_registered] = &any_properties_t_data_type<T, A>::instance;
+            word = static_cast<tag_word>((_compact_registered++ << compact_index_shift) | type_tags<T>());
+            _compact_word<T>.store(word, std::memory_order_release);
+        }
+        return word;
+    }
+
 public:
     constexpr explicit any() noexcept
     {
-        _properties = nullptr;
+        _tagged_properties = 0;
         clear_storage();
     }
 
     constexpr any(const any& rhs)
     {
-        if (rhs.has_value()) [[likely]]
+        _tagged_properties = rhs._tagged_properties;
+        if (_tagged_properties & trivial_tag)
         {
-            _properties = rhs._properties;
-            _properties->_clone(*this, rhs);
+            copy_storage(rhs);
+        }
+        else if (has_value()) [[likely]]
+        {
+            dispatch_clone(rhs);
         }
         else
         {
-            _properties = nullptr;
             clear_storage();
         }
     }
 
     any(any&& rhs) noexcept
     {
-        if (rhs.has_value()) [[likely]]
+        _tagged_properties = rhs._tagged_properties;
+        if (trivially_relocatable())
+        {
+            relocate_storage(rhs);
+        }
+        else if (has_value()) [[likely]]
         {
-            _properties = rhs._properties;
-            _properties->_move(*this, std::move(rhs));
+            dispatch_move(std::move(rhs));
         }
         else
         {
-            _properties = nullptr;
             clear_storage();
         }
     }
@@ -273,15 +578,16 @@ public:
     constexpr any(const U& value)
         requires(!is_an_any_v<U> && !is_an_any_v<std::remove_cvref_t<U>>)
     {
-        _properties = &any_properties_t_data_type<DU, A>::instance;
+        _tagged_properties = tagged_properties<DU>();
         if constexpr (is_inplace<DU>())
         {
             new (&inplace_data<DU>()) DU(value);
         }
         else
         {
-            set_pointer<DU>(new DU(value));
+            set_pointer<DU>(heap_new<DU>(value));
         }
+        value_stored<DU>();
     }
 
     template<typename U,
@@ -289,7 +595,7 @@ public:
     explicit constexpr any(U&& value)
         requires(!is_an_any_v<U> && !is_an_any_v<std::remove_cvref_t<U>>)
     {
-        _properties = &any_properties_t_data_type<DU, A>::instance;
+        _tagged_properties = tagged_properties<DU>();
         if constexpr (is_inplace<DU>())
         {
             // new (&inplace_data<DU>()) DU(std::forward<U>(value));
@@ -297,8 +603,9 @@ public:
         }
         else
         {
-            set_pointer<DU>(new DU(std::forward<U>(value)));
+            set_pointer<DU>(heap_new<DU>(std::forward<U>(value)));
         }
+        value_stored<DU>();
     }
 
     // #5 https://en.cppreference.com/w/cpp/utility/any/any
@@ -307,16 +614,17 @@ public:
         requires(!is_an_any_v<std::decay_t<T>> && !is_an_any_v<std::remove_cvref_t<T>> &&
                  std::is_constructible_v<std::decay_t<T>, Args...> && std::is_copy_constructible_v<std::decay_t<T>>)
     {
-        using DT    = std::decay_t<T>;
-        _properties = &any_properties_t_data_type<DT, A>::instance;
+        using DT           = std::decay_t<T>;
+        _tagged_properties = tagged_properties<DT>();
         if constexpr (is_inplace<DT>())
         {
             new (&inplace_data<DT>()) DT(std::forward<Args>(args)...);
         }
         else
         {
-            set_pointer<DT>(new DT(std::forward<Args>(args)...));
+            set_pointer<DT>(heap_new<DT>(std::forward<Args>(args)...));
         }
+        value_stored<DT>();
     }
 
     // #6 https://en.cppreference.com/w/cpp/utility/any/any
@@ -326,16 +634,17 @@ public:
                  std::is_constructible_v<std::decay_t<T>, std::initializer_list<U>&, Args...> &&
                  std::is_copy_constructible_v<std::decay_t<T>>)
     {
-        using DT    = std::decay_t<T>;
-        _properties = &any_properties_t_data_type<DT, A>::instance;
+        using DT           = std::decay_t<T>;
+        _tagged_properties = tagged_properties<DT>();
         if constexpr (is_inplace<DT>())
         {
             new (&inplace_data<DT>()) DT(il, std::forward<Args>(args)...);
         }
         else
         {
-            set_pointer<DT>(new DT(il, std::forward<Args>(args)...));
+            set_pointer<DT>(heap_new<DT>(il, std::forward<Args>(args)...));
         }
+        value_stored<DT>();
     }
 
     any& operator=(const any& rhs)
@@ -345,15 +654,22 @@ public:
 
         if (rhs.has_value()) [[likely]]
         {
-            if (has_value() && _properties == rhs._properties)
+            if (rhs._tagged_properties & trivial_tag)
+            {
+                reset();
+                _tagged_properties = rhs._tagged_properties;
+                copy_storage(rhs);
+            }
+            else if (_tagged_properties == rhs._tagged_properties)
             {
-                _properties->_assign_clone(*this, rhs);
+                dispatch_assign_clone(rhs);
+                copy_reserved(rhs);
             }
             else
             {
                 reset();
-                _properties = rhs._properties;
-                _properties->_clone(*this, rhs);
+                _tagged_properties = rhs._tagged_properties;
+                dispatch_clone(rhs);
             }
         }
         else
@@ -375,15 +691,24 @@ public:
         }
         if (has_value())
         {
-            if (_properties == rhs._properties)
+            if (_tagged_properties == rhs._tagged_properties && !(_tagged_properties & trivial_tag))
             {
-                _properties->_assign_move(*this, static_cast<void*>(&rhs));
+                dispatch_assign_move(rhs.value_address());
+                copy_reserved(rhs);
+                rhs.value_moved_from();
                 return *this;
             }
             reset();
         }
-        _properties = rhs._properties;
-        _properties->_move(*this, std::move(rhs));
+        _tagged_properties = rhs._tagged_properties;
+        if (trivially_relocatable())
+        {
+            relocate_storage(rhs);
+        }
+        else
+        {
+            dispatch_move(std::move(rhs));
+        }
         return *this;
     }
 
@@ -398,219 +723,475 @@ public:
     void reset()
     {
         // _delete in case of inplace - is not releasing memory, only calling destructor of the element inside _storage.
-        if (has_value())
+        if (has_value() && !(_tagged_properties & trivial_tag))
         {
-            _properties->_delete(*this);
+            dispatch_delete();
         }
-        _properties = nullptr;
+        _tagged_properties = 0;
         clear_storage();
     }
 
+    // value_address - the address of the stored value, in _storage or on the heap.
+    void* value_address() noexcept
+    {
+        return (_tagged_properties & inplace_tag) ? static_cast<void*>(&_storage) : get_pointer<void>();
+    }
+
+    // copy_storage / relocate_storage - the trivial copy and move of the value representation, no indirect call.
+    //  A relocated heap value is owned by this any only, an in place value stays in rhs as well, like after _move.
+    void copy_storage(const any& rhs) noexcept { std::memcpy(&_storage, &rhs._storage, sizeof(_storage)); }
+
+    void relocate_storage(any& rhs) noexcept
+    {
+        std::memcpy(&_storage, &rhs._storage, sizeof(_storage));
+        if (!(_tagged_properties & inplace_tag))
+        {
+            rhs._tagged_properties = 0;
+        }
+    }
+
+    // dispatch_* - the typed life cycle operations of the stored value (has_value() is true): an indirect call
+    //  through the properties, or with closed_dispatch a switch on the type index, see visit_type.
+    //  dispatch_clone and dispatch_move copy the reserved tail of the storage as well, dispatch_move then updates
+    //  the one of rhs, left with a moved-from value.
+    void dispatch_clone(const any& rhs)
+    {
+        if constexpr (closed_dispatch)
+            visit_type([&]<typename T>(std::type_identity<T>) {
+                any_properties_t_data_type<T, A>::clone_value(*this, rhs);
+            });
+        else
+            properties()->_cold->_clone(*this, rhs);
+        copy_reserved(rhs);
+    }
+
+    void dispatch_move(any&& rhs)
+    {
+        copy_reserved(rhs);
+        if constexpr (closed_dispatch)
+            visit_type([&]<typename T>(std::type_identity<T>) {
+                any_properties_t_data_type<T, A>::move_value(*this, std::move(rhs));
+            });
+        else
+            properties()->_move(*this, std::move(rhs));
+        rhs.value_moved_from();
+    }
+
+    void dispatch_delete()
+    {
+        if constexpr (closed_dispatch)
+            visit_type([&]<typename T>(std::type_identity<T>) {
+                any_properties_t_data_type<T, A>::delete_value(*this);
+            });
+        else
+            properties()->_delete(*this);
+    }
+
+    void dispatch_assign_clone(const any& rhs)
+    {
+        if constexpr (closed_dispatch)
+            visit_type([&]<typename T>(std::type_identity<T>) {
+                any_properties_t_data_type<T, A>::assign_clone_value(*this, rhs);
+            });
+        else
+            properties()->_cold->_assign_clone(*this, rhs);
+    }
+
+    void dispatch_assign_move(void* rhs_value)
+    {
+        if constexpr (closed_dispatch)
+            visit_type([&]<typename T>(std::type_identity<T>) {
+                any_properties_t_data_type<T, A>::assign_move_value(*this, rhs_value);
+            });
+        else
+            properties()->_cold->_assign_move(*this, rhs_value);
+    }
+
+    // reserved_storage - the reserved tail of _storage, see reserved_storage_size().
+    [[nodiscard]] void*       reserved_storage() noexcept { return &_storage[value_storage_size()]; }
+    [[nodiscard]] const void* reserved_storage() const noexcept { return &_storage[value_storage_size()]; }
+
+    void copy_reserved(const any& rhs) noexcept
+    {
+        if constexpr (reserved_storage_size() > 0)
+        {
+            std::memcpy(reserved_storage(), rhs.reserved_storage(), reserved_storage_size());
+        }
+    }
+
+    // value_stored<T> - a T value was stored from outside (not copied from another any), the Features with an
+    //  on_value_stored<T>(a) hook update their state, e.g. af_cached_hash.
+    template<typename T>
+    void value_stored()
+    {
+        (feature_value_stored<Features<A>, T>(), ...);
+    }
+
+    template<typename F, typename T>
+    void feature_value_stored()
+    {
+        if constexpr (requires(A& a) { F::template on_value_stored<T>(a); })
+        {
+            F::template on_value_stored<T>(*this);
+        }
+    }
+
+    // value_moved_from - the value was moved out of this any, which may still hold it in a moved-from state: the
+    //  Features with an on_value_moved_from(a) hook update their state.
+    void value_moved_from() noexcept
+    {
+        (feature_value_moved_from<Features<A>>(), ...);
+    }
+
+    template<typename F>
+    void feature_value_moved_from() noexcept
+    {
+        if constexpr (requires(A& a) { F::on_value_moved_from(a); })
+        {
+            F::on_value_moved_from(*this);
+        }
+    }
+
     // FIXME: TODO: implement template for any<M> where M != N, with different features
 
     template<typename U,
-             typename DU = std::enable_if_t<!std::is_same_v<any<N>, std::remove_cvref_t<U>>, std::remove_cvref_t<U>>>
+             typename DU = std::enable_if_t<!std::is_same_v<A, std::remove_cvref_t<U>>, std::remove_cvref_t<U>>>
     constexpr any& operator=(U& value)  // Check that it is / isn't an Any.
     {
-        if (has_value() && _properties == &any_properties_t_data_type<DU, A>::instance)  //->_type_info == typeid(DU))
+        if (_tagged_properties == tagged_properties<DU>())  //->_type_info == typeid(DU))
         {
-            _properties->_assign_clone(*this, value);
+            data<DU>() = value;
+            value_stored<DU>();
             return *this;
         }
         reset();
-        _properties = &any_properties_t_data_type<DU, A>::instance;
+        _tagged_properties = tagged_properties<DU>();
         if constexpr (is_inplace<DU>())
         {
-            inplace_data<DU>() = value;
+            new (&inplace_data<DU>()) DU(value);
         }
         else
         {
-            set_pointer<DU>(new DU(value));
+            set_pointer<DU>(heap_new<DU>(value));
         }
+        value_stored<DU>();
         return *this;
     }
 
-    template<typename U, typename DU = std::enable_if_t<!std::is_same_v<any<N>, std::decay_t<U>>, U>>
+    template<typename U, typename DU = std::enable_if_t<!std::is_same_v<A, std::decay_t<U>>, U>>
     constexpr any& operator=(U&& value)
     {
-        if (has_value() && _properties == &any_properties_t_data_type<DU, A>::instance)  //->_type_info == typeid(DU))
+        if (_tagged_properties == tagged_properties<DU>())  //->_type_info == typeid(DU))
         {
-            _properties->_assign_move(*this, static_cast<void*>(&value));
+            dispatch_assign_move(static_cast<void*>(&value));
+            value_stored<DU>();
             return *this;
         }
         reset();
-        _properties = &any_properties_t_data_type<DU, A>::instance;
+        _tagged_properties = tagged_properties<DU>();
         if constexpr (is_inplace<DU>())
         {
             new (&_storage) DU(std::forward<U>(value));
         }
         else
         {
-            set_pointer<DU>(new DU(std::forward<U>(value)));
+            set_pointer<DU>(heap_new<DU>(std::forward<U>(value)));
         }
+        value_stored<DU>();
         return *this;
     }
 
     [[nodiscard]] constexpr bool inplace() const noexcept
     {  // return true if no stored value
-        if (!has_value() || _properties->_inplace_flag) return true;
+        if (!has_value() || (_tagged_properties & inplace_tag)) return true;
         return false;
     }
-    constexpr static size_t in_place_capacity() noexcept { return storage_size(); }
+    // trivial - the stored value is in place and trivially copyable, see is_trivial<T>().
+    [[nodiscard]] constexpr bool trivial() const noexcept { return _tagged_properties & trivial_tag; }
+    // trivially_relocatable - moving the value is a memcpy of _storage: trivial or heap stored.
+    [[nodiscard]] constexpr bool trivially_relocatable() const noexcept
+    {
+        return has_value() && (_tagged_properties & (trivial_tag | inplace_tag)) != inplace_tag;
+    }
+    constexpr static size_t in_place_capacity() noexcept { return value_storage_size(); }
+
+    [[nodiscard]] constexpr bool has_value() const noexcept { return 0 != _tagged_properties; }
+
+    // type_index - with closed_dispatch, the 1 based index of the stored value type in closed_types, 0 when empty.
+    [[nodiscard]] constexpr size_t type_index() const noexcept
+    {
+        return (_tagged_properties & type_index_mask) >> type_index_shift;
+    }
+
+    // visit_type - calls f(std::type_identity<T>{}) with T the type of the stored value, the any must hold a value.
+    //  A switch on type_index(), which the compiler turns into a jump table with f inlined in each case, as for
+    //  std::visit of a std::variant. All the cases must return the same type.
+    template<typename F>
+    constexpr decltype(auto) visit_type(F&& f) const
+    {
+        static_assert(closed_dispatch, "visit_type requires a closed type set of at most 15 types, see af_variant");
+        using R = std::invoke_result_t<F&, std::type_identity<closed_type<0>>>;
+        switch (type_index())
+        {
+        case 1: return visit_case<1, R>(f);
+        case 2: return visit_case<2, R>(f);
+        case 3: return visit_case<3, R>(f);
+        case 4: return visit_case<4, R>(f);
+        case 5: return visit_case<5, R>(f);
+        case 6: return visit_case<6, R>(f);
+        case 7: return visit_case<7, R>(f);
+        case 8: return visit_case<8, R>(f);
+        case 9: return visit_case<9, R>(f);
+        case 10: return visit_case<10, R>(f);
+        case 11: return visit_case<11, R>(f);
+        case 12: return visit_case<12, R>(f);
+        case 13: return visit_case<13, R>(f);
+        case 14: return visit_case<14, R>(f);
+        case 15: return visit_case<15, R>(f);
+        default: std::unreachable();
+        }
+    }
+
+private:
+    template<size_t I, typename R, typename F>
+    constexpr static R visit_case(F& f)
+    {
+        if constexpr (I <= closed_type_count())
+        {
+            return f(std::type_identity<closed_type<I - 1>>{});
+        }
+        else
+        {
+            std::unreachable();
+        }
+    }
 
-    [[nodiscard]] constexpr bool has_value() const noexcept { return nullptr != _properties; }
+public:
 
     // Note: standard cast_any<T> returns T value, a copy of the content of A, while ext::any<> returns a T&
     // std::any_cast is returning T a copy of the stored item, the any_cast below returns T& to the stored item.
 
+    // holds<T> - first the identity check against the properties of T (one compare of the tagged word, no memory
+    //  access). With RTTI, then the fingerprint compare and the type_info compare, which match the same type whose
+    //  properties were instantiated in another shared object. Without RTTI the identity check only: two types can
+    //  have the same name (in anonymous namespaces of two translation units, local classes) or the same fingerprint,
+    //  a fingerprint is not a proof of the type.
+    //  Note: 'if constexpr (rtti_available)' does not work here, typeid(T) is rejected before the if constexpr.
     template<typename T>
-    [[nodiscard]] constexpr friend T& any_cast(any& a)
+    [[nodiscard]] bool holds() const noexcept
     {
-#ifdef ANY_RTTI_ON
-        if (!a.has_value() || *a._properties->_type_info != typeid(T))
+        if constexpr (closed_type_count() > 0 && index_of<std::decay_t<T>>() == 0)
         {
-            throw std::bad_any_cast{};
+            return false;  // not one of the closed_types, it has no properties.
         }
+        else
+        {
+            const tag_word word{known_tagged_properties<std::decay_t<T>>()};
+            if (_tagged_properties == word && (!compact || has_value())) [[likely]]
+                return true;
+#ifdef ANY_RTTI_ON
+            constexpr uint64_t fingerprint{type_fingerprint<std::decay_t<T>>()};
+            return has_value() && properties()->_cold->_fingerprint == fingerprint &&
+                   *properties()->_cold->_type_info == typeid(T);
 #else
-        if (!a.has_value() || a.properties() != &any_properties_t_data_type<std::decay_t<T>, A>::instance)
+            return false;
+#endif
+        }
+    }
+
+    template<typename T>
+    [[nodiscard]] constexpr friend T& any_cast(any& a)
+    {
+        if (!a.template holds<T>()) [[unlikely]]
         {
             throw std::bad_any_cast{};
         }
-
-#endif
         return a.data<T>();
     }
 
     template<typename T>
     [[nodiscard]] constexpr friend const T& any_cast(const any& a)
     {
-#ifdef ANY_RTTI_ON
-        if (!a.has_value() || *a._properties->_type_info != typeid(T))
-        {
-            throw std::bad_any_cast{};
-        }
-#else
-        if (!a.has_value() || a.properties() != &any_properties_t_data_type<std::decay_t<T>, A>::instance)
+        if (!a.template holds<T>()) [[unlikely]]
         {
             throw std::bad_any_cast{};
         }
-#endif
         return a.data<T>();
     }
-    // The following code does not work as the access to typeid is happening before the if constexpr.
-    //  Is it a compilers bug?
-    //        if constexpr (rtti_available)
-    //        {
-    //            if (!a.has_value() || *a._properties->_type_info != typeid(T))
-    //            {
-    //                throw std::bad_any_cast{};
-    //            }
-    //        }
-    //        else
-    //        {
-    //            if (!a.has_value() || a.properties() != &any_properties_t_data_type<std::decay_t<T>, A>::instance)
-    //            {
-    //                throw std::bad_any_cast{};
-    //            }
-    //        }
-    //        return a.data<T>();
 
     template<typename T>
     [[nodiscard]] constexpr friend T* any_cast(any* ap) noexcept
     {
-#ifdef ANY_RTTI_ON
-        if (!ap->has_value() || *ap->_properties->_type_info != typeid(T))
-        {
-            return nullptr;
-        }
-#else
-        if (!ap->has_value() || ap->properties() != &any_properties_t_data_type<std::decay_t<T>, A>::instance)
+        if (!ap->template holds<T>()) [[unlikely]]
         {
             return nullptr;
         }
-#endif
-        // Nicer code, but does not compile :-)
-        //        if constexpr (rtti_available)
-        //        {
-        //            if (!ap->has_value() || *ap->_properties->_type_info != typeid(T)) return nullptr;
-        //        }
-        //        else
-        //        {
-        //            if (!ap->has_value() || ap->properties() != &any_properties_t_data_type<std::decay_t<T>,
-        //            A>::instance)
-        //                return nullptr;
-        //        }
         return &ap->data<T>();
     }
 
     template<typename T>
     [[nodiscard]] constexpr friend const T* any_cast(const any* ap) noexcept
     {
-#ifdef ANY_RTTI_ON
-        if (!ap->has_value() || *ap->_properties->_type_info != typeid(T))
-        {
-            return nullptr;
-        }
-#else
-        if (!ap->has_value() || ap->properties() != &any_properties_t_data_type<std::decay_t<T>, A>::instance)
+        if (!ap->template holds<T>()) [[unlikely]]
         {
             return nullptr;
         }
-#endif
         return &ap->data<T>();
     }
 
-#ifdef ANY_RTTI_ON
-    [[nodiscard]] constexpr const std::type_info& type() const noexcept
+    // unchecked_any_cast<T> - no check at all, for code that already established that the any holds a T.
+    template<typename T>
+    [[nodiscard]] friend T& unchecked_any_cast(any& a) noexcept
     {
-        if (has_value()) return *_properties->_type_info;
-        return typeid(void);
+        return a.data<T>();
     }
-#endif
 
-    template<typename T, typename... Arg>
-    T& emplace(Arg&&... args)
+    template<typename T>
+    [[nodiscard]] friend const T& unchecked_any_cast(const any& a) noexcept
     {
-        using DT = std::decay_t<T>;
+        return a.data<T>();
+    }
+
+    // type_handle<T> - a type check done once, then each element is tested with one compare of the tagged word,
+    //  and accessed with a direct load. Constructed from a sample any, it also matches the properties of T of
+    //  another shared object.
+    //      const AT::type_handle<int> h{v[0]};
+    //      for (const auto& a : v) if (h.holds(a)) sum += h.get(a);
+    template<typename T>
+    class type_handle
+    {
+    public:
+        // registers T with the compact layout, see tagged_properties<T>().
+        constexpr type_handle() noexcept(!compact) : _tagged_properties(tagged_properties<T>()) {}
+        explicit type_handle(const any& sample) : _tagged_properties(sample._tagged_properties)
+        {
+            if (!sample.template holds<T>())
+            {
+                throw std::bad_any_cast{};
+            }
+        }
+
+        [[nodiscard]] bool holds(const any& a) const noexcept { return a._tagged_properties == _tagged_properties; }
+
+        [[nodiscard]] T&       get(any& a) const noexcept { return a.data<T>(); }
+        [[nodiscard]] const T& get(const any& a) const noexcept { return a.data<T>(); }
+
+        [[nodiscard]] T*       get_if(any& a) const noexcept { return holds(a) ? &a.data<T>() : nullptr; }
+        [[nodiscard]] const T* get_if(const any& a) const noexcept { return holds(a) ? &a.data<T>() : nullptr; }
+
+    private:
+        tag_word _tagged_properties;
+    };
+
+#ifdef ANY_RTTI_ON
+    [[nodiscard]] constexpr const std::type_info& type() const noexcept
+    {
+        if (has_value()) return *properties()->_cold->_type_info;
+        return typeid(void);
+    }
+#endif
+
+    template<typename T, typename... Arg>
+    T& emplace(Arg&&... args)
+    {
+        using DT = std::decay_t<T>;
         reset();
-        _properties = &any_properties_t_data_type<DT, A>::instance;
+        // the tag word first, it throws with the compact layout when no more types can be registered, then the
+        //  properties are set once the value is constructed: when its constructor throws, the any stays empty.
+        const tag_word word{tagged_properties<DT>()};
         if constexpr (is_inplace<DT>())
         {
             new (&_storage) DT{std::forward<Arg>(args)...};
-            return inplace_data<DT>();
         }
-        else
+        else if constexpr (std::is_void_v<heap_allocator>)
         {
             set_pointer<DT>(new DT{std::forward<Arg>(args)...});
-            return storage_dynamic<DT>();
         }
+        else
+        {
+            DT* p{heap_allocator::template heap_allocate<DT>()};
+            try
+            {
+                set_pointer<DT>(new (p) DT{std::forward<Arg>(args)...});
+            }
+            catch (...)
+            {
+                heap_allocator::template heap_deallocate<DT>(p);
+                throw;
+            }
+        }
+        _tagged_properties = word;
+        value_stored<DT>();
+        return data<DT>();
     }
 
     [[nodiscard]] std::string_view src_type_name() const
     {
-        if (has_value()) return _properties->_src_type_name;
+        if (has_value()) return properties()->_cold->_src_type_name;
         return "empty";
     }
 
     [[nodiscard]] size_t value_size() const
     {
-        if (has_value()) return _properties->_value_size;
+        if (has_value()) return properties()->_cold->_value_size;
         return 0;
     }
 
     explicit any(const char* p) : any(std::string{p}) {}
 
-    [[nodiscard]] constexpr const any_properties* properties() const noexcept { return _properties; }
+    [[nodiscard]] constexpr const any_properties* properties() const noexcept
+    {
+        if constexpr (compact)
+        {
+            return _compact_registry[_tagged_properties >> compact_index_shift];
+        }
+        else
+        {
+            return std::bit_cast<const any_properties*>(_tagged_properties & ~tags_mask);
+        }
+    }
+    [[nodiscard]] const any_properties_cold* cold_properties() const noexcept
+    {
+        return has_value() ? properties()->_cold : nullptr;
+    }
 
-private:
-    const any_properties* _properties{nullptr};
-    union
+    // fingerprint - type_fingerprint<T>() of the value type, 0 when empty:
+    //      switch (a.fingerprint()) { case ext::type_fingerprint<int>(): ... }
+    [[nodiscard]] uint64_t fingerprint() const noexcept
     {
-        char  _storage[storage_size()];
-        void* _pointer;
-    };
+        return has_value() ? properties()->_cold->_fingerprint : 0;
+    }
+
+    // type_order - the order of the value types of two anys holding values: by type_fingerprint<T>(), then two
+    //  distinct types with the same fingerprint (the same name in the anonymous namespaces of two translation units)
+    //  by the address of their properties. equivalent only for the same type: the same properties, or with RTTI the
+    //  same type_info, the type of properties instantiated in another shared object.
+    [[nodiscard]] static std::weak_ordering type_order(const any_properties* a, const any_properties* b) noexcept
+    {
+        if (a == b)
+        {
+            return std::weak_ordering::equivalent;
+        }
+        if (const auto by_fingerprint{a->_cold->_fingerprint <=> b->_cold->_fingerprint}; by_fingerprint != 0)
+        {
+            return by_fingerprint;
+        }
+#ifdef ANY_RTTI_ON
+        if (*a->_cold->_type_info == *b->_cold->_type_info)
+        {
+            return std::weak_ordering::equivalent;
+        }
+#endif
+        return std::compare_three_way{}(a, b);
+    }
+
+private:
+    // The storage first: with the compact layout the 4 bytes tag word fills the tail padding,
+    //  any<12, af_compact> is 16 bytes and any<4, af_compact> is 8 bytes.
+    alignas(void*) char _storage[storage_size()];
+    tag_word            _tagged_properties{0};
     static_assert(sizeof(_storage) == storage_size(), "N is too small");
-    static_assert(sizeof(_storage) >= sizeof(void*), "_storage size too small");
+    static_assert(compact || sizeof(_storage) >= sizeof(void*), "_storage size too small");
 
     template<typename T, typename U>
     friend struct any_properties_t_data_type;
@@ -620,105 +1201,170 @@ static_assert(sizeof(any<8>) == 8 + 8, "wrong storage for any");
 static_assert(sizeof(any<16>) == 16 + 8, "wrong storage for any");
 static_assert(sizeof(any<24>) == 24 + 8, "wrong storage for any");
 static_assert(sizeof(any<32>) == 32 + 8, "wrong storage for any");
+static_assert(alignof(any<8>::any_properties) > any<8>::tags_mask, "properties pointer tags need the alignment");
 
 template<typename T, size_t N, template<typename> class... Features>
 struct any_properties_t_data_type<T, any<N, Features...>> final
 {
     using A = any<N, Features...>;
 
-public:
-    static inline const A::any_properties instance{[]() -> A::any_properties {
-        typename A::any_properties properties{};
-        properties._inplace_flag          = A::template is_inplace<T>();
-        properties._is_move_constructible = std::is_move_constructible_v<T>;
-        properties._is_copy_constructible = std::is_copy_constructible_v<T>;
-#ifdef ANY_RTTI_ON
-        properties._type_info  = &typeid(T);
-        properties._type_index = std::type_index(typeid(T));
-#endif
-        properties._src_type_name = src_type_name<T>();
-        properties._value_size    = sizeof(T);
+    // The typed operations behind the properties' function pointers, also called directly by the closed type set
+    //  dispatch (af_variant).
+    static void destroy_value(A& a)
+    {
+        T* p = &a.template data<T>();
+        p->T::~T();
+    }
 
-        properties._destroy = +[](A& a) -> void {
-            T* p = &a.template data<T>();
-            p->T::~T();
-        };
-        properties._delete = +[](A& a) -> void {
-            if constexpr (A::template is_inplace<T>())
-            {
-                (&a.template inplace_data<T>())->T::~T();
-            }
-            else
-            {
-                T* p{a.template get_pointer<T>()};
-                delete p;
-                a.template set_pointer<void>(nullptr);
-            }
-        };
-        properties._clone = +[](A& a, const A& b) -> void {
-            if constexpr (!std::is_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
-            {
-                throw std::runtime_error("trying to clone non-copyable type");
-            }
-            else
-            {
-                if constexpr (A::template is_inplace<T>())
-                {
-                    new (&a.template inplace_data<T>()) T(b.template inplace_data<T>());
-                }
-                else
-                {
-                    const T* cp{b.template get_pointer<T>()};
-                    a.template set_pointer<T>(new T(*cp));
-                }
-            }
-        };
-        properties._move = +[](A& lhs, A&& rhs) -> void {
-            if constexpr (A::template is_inplace<T>())
-            {
-                new (&lhs.template inplace_data<T>()) T(std::move(rhs.template inplace_data<T>()));
-            }
-            else
-            {
-                lhs._properties = rhs._properties;
-                lhs.template set_pointer<T>(rhs.template get_pointer<T>());
-                rhs.template set_pointer<void>(nullptr);
-                rhs._properties = nullptr;
-            }
-        };
-        properties._assign_clone = +[](A& a, const A& b) -> void {
+    static void delete_value(A& a)
+    {
+        if constexpr (A::template is_inplace<T>())
+        {
+            (&a.template inplace_data<T>())->T::~T();
+        }
+        else
+        {
+            A::template heap_delete<T>(a.template get_pointer<T>());
+            a.template set_pointer<void>(nullptr);
+        }
+    }
+
+    static void clone_value(A& a, const A& b)
+    {
+        if constexpr (!std::is_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+        {
+            throw std::runtime_error("trying to clone non-copyable type");
+        }
+        else
+        {
             if constexpr (A::template is_inplace<T>())
             {
-                a.template inplace_data<T>() = b.template inplace_data<T>();
+                new (&a.template inplace_data<T>()) T(b.template inplace_data<T>());
             }
             else
             {
-                auto& ap{*std::bit_cast<T**>(&a._pointer)};
-                auto& bp{*std::bit_cast<T* const*>(&b._pointer)};
-                *ap = *bp;
-            }
-        };
-        properties._assign_move = +[](A& a, void* bvp) -> void {
-            if constexpr (A::template is_inplace<T>())
-            {
-                a.template inplace_data<T>() = std::move(*std::bit_cast<T*>(bvp));
+                const T* cp{b.template get_pointer<T>()};
+                a.template set_pointer<T>(A::template heap_new<T>(*cp));
             }
-            else
+        }
+    }
+
+    static void move_value(A& lhs, A&& rhs)
+    {
+        if constexpr (A::template is_inplace<T>())
+        {
+            new (&lhs.template inplace_data<T>()) T(std::move(rhs.template inplace_data<T>()));
+        }
+        else
+        {
+            lhs._tagged_properties = rhs._tagged_properties;
+            lhs.template set_pointer<T>(rhs.template get_pointer<T>());
+            rhs.template set_pointer<void>(nullptr);
+            rhs._tagged_properties = 0;
+        }
+    }
+
+    static void assign_clone_value(A& a, const A& b)
+    {
+        if constexpr (A::template is_inplace<T>())
+        {
+            a.template inplace_data<T>() = b.template inplace_data<T>();
+        }
+        else
+        {
+            *a.template get_pointer<T>() = *b.template get_pointer<T>();
+        }
+    }
+
+    static void assign_move_value(A& a, void* bvp)
+    {
+        if constexpr (A::template is_inplace<T>())
+        {
+            a.template inplace_data<T>() = std::move(*std::bit_cast<T*>(bvp));
+        }
+        else
+        {
+            *a.template get_pointer<T>() = std::move(*std::bit_cast<T*>(bvp));
+        }
+    }
+
+    static void reset_values(A* a, size_t n)
+    {
+        for (size_t i{0}; i < n; ++i)
+        {
+            if constexpr (!A::template is_trivial<T>())
             {
-                auto ap{*std::bit_cast<T**>(&a._pointer)};
-                auto bp{std::bit_cast<T*>(bvp)};
-                *ap = std::move(*bp);
+                delete_value(a[i]);
             }
-        };
+            a[i]._tagged_properties = 0;
+        }
+    }
+
+private:
+    template<typename F>
+    static constexpr void construct_extend_cold_properties(auto& properties)
+    {
+        if constexpr (requires { typename F::extend_cold_properties; })
+        {
+            F::template construct_extend_cold_properties<T>(properties);
+        }
+    }
+
+    static constexpr A::any_properties_cold make_cold_properties()
+    {
+        typename A::any_properties_cold properties{};
+        properties._inplace_flag              = A::template is_inplace<T>();
+        properties._is_move_constructible     = std::is_move_constructible_v<T>;
+        properties._is_copy_constructible     = std::is_copy_constructible_v<T>;
+        properties._is_trivially_copyable     = A::template is_trivial<T>();
+        properties._is_trivially_destructible = A::template is_inplace<T>() && std::is_trivially_destructible_v<T>;
+        properties._is_trivially_relocatable  = !A::template is_inplace<T>() || std::is_trivially_copyable_v<T>;
+#ifdef ANY_RTTI_ON
+        properties._type_info = &typeid(T);
+#endif
+        properties._src_type_name = src_type_name<T>();
+        properties._value_size    = sizeof(T);
+        properties._fingerprint   = type_fingerprint<T>();
+
+        properties._destroy      = &destroy_value;
+        properties._clone        = &clone_value;
+        properties._assign_clone = &assign_clone_value;
+        properties._assign_move  = &assign_move_value;
+        properties._reset_n      = &reset_values;
+        (void)((construct_extend_cold_properties<Features<A>>(properties)), ...);
+        return properties;
+    }
+
+    static constexpr A::any_properties make_properties()
+    {
+        typename A::any_properties properties{};
+        properties._cold   = &cold_instance;
+        properties._delete = &delete_value;
+        properties._move   = &move_value;
         (void)((Features<A>::template construct_extend_properties<T>(properties)), ...);
         return properties;
-    }()};
+    }
+
+public:
+    // Both tables are constant initialized: no dynamic initialization, no guard on first use.
+    static constexpr typename A::any_properties_cold cold_instance{make_cold_properties()};
+    static constexpr typename A::any_properties      instance{make_properties()};
 };
 
 // ====================================================== any_features.h
 // Features - optional features for any<N, Features...>
 // construct - on the objects themselves.
-// properties_construct - once per-type when creating the instance of the properties.
+// properties_construct - once per-type when creating the instance of the properties, at compile time:
+//   construct_extend_properties<T>() and construct_extend_cold_properties<T>() must be constexpr.
+// extend_properties - hot dispatch pointers, first in any_properties, kept in one cache line (static_assert'ed): up
+//   to five pointers of all the Features together.
+// extend_cold_properties - optional, I/O and diagnostic pointers, in any_properties_cold, set by
+//   construct_extend_cold_properties<T>(). The batch operations over n anys of one type (the *_n pointers,
+//   used by any_column) are cold too, one indirect call per run of values.
+// reserved_storage_size() - optional, bytes kept at the end of the storage for the Feature, see af_cached_hash.
+// on_value_stored<T>(a) - optional, called after a T value is stored in a from outside, not on copy or move.
+// on_value_moved_from(a) - optional, called after the value of a was moved out by a non-trivial move, a may still
+//   hold the moved-from value.
 template<typename T>
 struct af_streamed;
 
@@ -728,31 +1374,65 @@ struct af_streamed<any<N, Features...>>
     using A = any<N, Features...>;
     struct extend_properties
     {
-        extend_properties() = default;
+    };
+    struct extend_cold_properties
+    {
+        extend_cold_properties() = default;
         std::ostream& (*_ostream)(std::ostream&, const A&){nullptr};
+        std::ostream& (*_ostream_n)(std::ostream&, const A*, size_t, std::string_view){nullptr};
     };
 
     template<typename T>
-    static void construct_extend_properties(auto& prop)
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static std::ostream& ostream_value(std::ostream& os, const A& a)
+    {
+        if constexpr (requires(T t) { os << t; })
+        {
+            if (a.has_value())
+            {
+                const T& value{a.template data<T>()};
+                return os << value;
+            }
+        }
+        return os;
+    }
+
+    // ostream_values - the n values separated by sep.
+    template<typename T>
+    static std::ostream& ostream_values(std::ostream& os, const A* a, size_t n, std::string_view sep)
     {
-        prop._ostream = +[](std::ostream& os, const A& a) -> std::ostream& {
+        for (size_t i{0}; i < n; ++i)
+        {
+            if (i) os << sep;
             if constexpr (requires(T t) { os << t; })
             {
-                if (a.has_value())
-                {
-                    const T& value{a.template data<T>()};
-                    return os << value;
-                }
+                os << a[i].template data<T>();
             }
-            return os;
-        };
+        }
+        return os;
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        prop._ostream   = &ostream_value<T>;
+        prop._ostream_n = &ostream_values<T>;
     }
 
     friend std::ostream& operator<<(std::ostream& os, const A& a)
     {
         if (a.has_value())
         {
-            return a.properties()->_ostream(os, a);
+            if constexpr (A::closed_dispatch)
+                return a.visit_type([&]<typename T>(std::type_identity<T>) -> std::ostream& {
+                    return ostream_value<T>(os, a);
+                });
+            else
+                return a.cold_properties()->_ostream(os, a);
         }
         return os;
     }
@@ -766,107 +1446,373 @@ struct af_strict_streamed<any<N, Features...>>
 {
     using A = any<N, Features...>;
     struct extend_properties
+    {
+    };
+    struct extend_cold_properties
     {
         std::ostream& (*_strict_ostream)(std::ostream&, const A&);
     };
 
     template<typename T>
-    static void construct_extend_properties(auto& prop)
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
         requires requires(T t) { std::cout << t; }
     {
         static_assert(requires(T t) { std::cout << t; }, "af_strict_streamed requires type supporting 'operator<< T{}");
-        prop._strict_ostream = +[](std::ostream& os, const A& a) -> std::ostream& {
-            if (a.has_value())
-            {
-                const T& value{a.template data<T>()};
-                return os << value;
-            }
-            return os;
-        };
+        prop._strict_ostream = &strict_ostream_value<T>;
+    }
+
+    template<typename T>
+    static std::ostream& strict_ostream_value(std::ostream& os, const A& a)
+    {
+        const T& value{a.template data<T>()};
+        return os << value;
     }
 
     friend std::ostream& operator<<(std::ostream& os, const A& a)
     {
         if (a.has_value())
         {
-            return a.properties()->_strict_ostream(os, a);
+            if constexpr (A::closed_dispatch)
+                return a.visit_type([&]<typename T>(std::type_identity<T>) -> std::ostream& {
+                    return strict_ostream_value<T>(os, a);
+                });
+            else
+                return a.cold_properties()->_strict_ostream(os, a);
         }
         return os;
     }
 };
 
+namespace to_chars_detail {
+// the poison pill: the unqualified to_chars below finds the overloads of the user types by ADL only.
+void to_chars() = delete;
+
 template<typename T>
-struct af_strict_less;
+concept has_adl_to_chars = requires(char* p, const T& value) {
+    { to_chars(p, p, value) } -> std::same_as<std::to_chars_result>;
+};
+}  // namespace to_chars_detail
 
-template<size_t N, template<typename> class... Features>
-struct af_strict_less<any<N, Features...>>
+// to_chars_value - the text of value in [first, last), std::to_chars_result like std::to_chars:
+//  the arithmetic types by std::to_chars (shortest round trip for the floating point), bool as true / false, the
+//  characters and the strings as they are, the user types by their to_chars(char*, char*, const T&) found by ADL.
+//  Any other type fails with std::errc::invalid_argument.
+template<typename T>
+std::to_chars_result to_chars_value(char* first, char* last, const T& value)
 {
-    using A = any<N, Features...>;
-
-    struct extend_properties
+    if constexpr (std::is_same_v<T, bool>)
     {
-        bool (*_strict_less)(const A&, const A&){nullptr};
-    };
-
-    template<typename T>
-    static void construct_extend_properties(auto& prop)
+        return to_chars_value(first, last, std::string_view{value ? "true" : "false"});
+    }
+    else if constexpr (std::is_same_v<T, char>)
     {
-        static_assert(requires(T ta, T tb) { ta < tb; }, "af_strict_less requires type supporting 'a < b' compare");
-
-        prop._strict_less = +[](const A& a, const A& b) -> bool {
-            const T& a_value{a.template data<T>()};
-            const T& b_value{b.template data<T>()};
-            return a_value < b_value;
-        };
+        return to_chars_value(first, last, std::string_view{&value, 1});
     }
-
-    friend bool operator<(const A& lhs, const A& rhs)
+    else if constexpr (std::is_arithmetic_v<T>)
     {
-        if (lhs.has_value() && rhs.has_value())
+        return std::to_chars(first, last, value);
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        const std::string_view text{value};
+        if (text.size() > static_cast<size_t>(last - first))
         {
-            if (lhs.properties() == rhs.properties())
-            {
-                return lhs.properties()->_strict_less(lhs, rhs);
-            }
-            throw std::runtime_error("any operator less '<': with different types");
+            return {last, std::errc::value_too_large};
         }
-        throw std::runtime_error("empty ext::any value in operator less '<'");
+        return {std::copy(text.begin(), text.end(), first), std::errc{}};
     }
-};
+    else if constexpr (to_chars_detail::has_adl_to_chars<T>)
+    {
+        using to_chars_detail::to_chars;
+        return to_chars(first, last, value);
+    }
+    else
+    {
+        return {first, std::errc::invalid_argument};
+    }
+}
 
 template<typename T>
-struct af_strict_eq;
+struct af_to_chars;
 
+// af_to_chars - to_chars(first, last, a), found by ADL: the value as text in a char buffer, with to_chars_value of
+//  its type. No stream and no allocation, for the logging of values from the hot path. An empty any writes nothing.
 template<size_t N, template<typename> class... Features>
-struct af_strict_eq<any<N, Features...>>
+struct af_to_chars<any<N, Features...>>
 {
     using A = any<N, Features...>;
-
     struct extend_properties
     {
-        bool (*_strict_eq)(const A&, const A&){nullptr};
+    };
+    struct extend_cold_properties
+    {
+        std::to_chars_result (*_to_chars)(char*, char*, const A&){nullptr};
     };
 
     template<typename T>
-    static void construct_extend_properties(auto& prop)
+    static constexpr void construct_extend_properties(auto&)
     {
-        static_assert(requires(T ta, T tb) { ta == tb; }, "af_strict_eq requires type supporting 'a == b' compare");
+    }
 
-        prop._strict_eq = +[](const A& a, const A& b) -> bool {
-            const T& a_value{a.template data<T>()};
-            const T& b_value{b.template data<T>()};
-            return a_value == b_value;
-        };
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        prop._to_chars = &to_chars_any_value<T>;
     }
 
-    friend bool operator==(const A& lhs, const A& rhs)
+    template<typename T>
+    static std::to_chars_result to_chars_any_value(char* first, char* last, const A& a)
     {
-        if (lhs.has_value() && rhs.has_value())
-        {
-            if (lhs.properties() == rhs.properties())
-            {
-                return lhs.properties()->_strict_eq(lhs, rhs);
-            }
+        return to_chars_value(first, last, a.template data<T>());
+    }
+
+    friend std::to_chars_result to_chars(char* first, char* last, const A& a)
+    {
+        if (!a.has_value())
+            return {first, std::errc{}};
+        if constexpr (A::closed_dispatch)
+            return a.visit_type(
+                [&]<typename T>(std::type_identity<T>) { return to_chars_any_value<T>(first, last, a); });
+        else
+            return a.cold_properties()->_to_chars(first, last, a);
+    }
+};
+
+#if defined(__cpp_lib_format)
+template<typename T>
+struct af_formatted;
+
+// af_formatted - std::format("{}", a) and std::format_to(out, "{:>8.3}", a): the value is written by the
+//  std::formatter of its type, straight into the output of the format context, with the format spec of the
+//  replacement field. No stream, no locale, no temporary string. Relaxed like af_streamed: an empty any, or a value
+//  with no std::formatter, writes nothing.
+template<size_t N, template<typename> class... Features>
+struct af_formatted<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+    struct extend_properties
+    {
+    };
+    struct extend_cold_properties
+    {
+        std::format_context::iterator (*_format)(const A&, std::string_view, std::format_context&){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        prop._format = &format_value<T>;
+    }
+
+    // format_value - the spec, parsed by the std::formatter of T, then the value formatted to ctx.out().
+    template<typename T>
+    static std::format_context::iterator format_value(const A& a, std::string_view spec, std::format_context& ctx)
+    {
+        if constexpr (std::is_default_constructible_v<std::formatter<T, char>>)
+        {
+            std::formatter<T, char>   formatter;
+            std::format_parse_context parse_ctx{spec};
+            parse_ctx.advance_to(formatter.parse(parse_ctx));
+            return formatter.format(a.template data<T>(), ctx);
+        }
+        else
+        {
+            return ctx.out();
+        }
+    }
+
+    static std::format_context::iterator format(const A& a, std::string_view spec, std::format_context& ctx)
+    {
+        if (!a.has_value())
+            return ctx.out();
+        if constexpr (A::closed_dispatch)
+            return a.visit_type([&]<typename T>(std::type_identity<T>) { return format_value<T>(a, spec, ctx); });
+        else
+            return a.cold_properties()->_format(a, spec, ctx);
+    }
+};
+#endif
+
+template<typename T>
+struct af_strict_less;
+
+template<size_t N, template<typename> class... Features>
+struct af_strict_less<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    struct extend_properties
+    {
+        bool (*_strict_less)(const A&, const A&){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto& prop)
+    {
+        static_assert(requires(T ta, T tb) { ta < tb; }, "af_strict_less requires type supporting 'a < b' compare");
+
+        prop._strict_less = &strict_less_value<T>;
+    }
+
+    template<typename T>
+    static bool strict_less_value(const A& a, const A& b)
+    {
+        const T& a_value{a.template data<T>()};
+        const T& b_value{b.template data<T>()};
+        return a_value < b_value;
+    }
+
+    friend bool operator<(const A& lhs, const A& rhs)
+    {
+        if (lhs.has_value() && rhs.has_value())
+        {
+            if (lhs.properties() == rhs.properties())
+            {
+                if constexpr (A::closed_dispatch)
+                    return lhs.visit_type(
+                        [&]<typename T>(std::type_identity<T>) { return strict_less_value<T>(lhs, rhs); });
+                else
+                    return lhs.properties()->_strict_less(lhs, rhs);
+            }
+            throw std::runtime_error("any operator less '<': with different types");
+        }
+        throw std::runtime_error("empty ext::any value in operator less '<'");
+    }
+};
+
+// is_bitwise_comparable<T> - a == b exactly when the object representations of a and b are equal: the scalar
+//  types with unique object representations. Specialize it for a struct with a defaulted operator==, and no padding.
+template<typename T>
+struct is_bitwise_comparable
+    : std::bool_constant<(std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) &&
+                         std::has_unique_object_representations_v<T>>
+{
+};
+template<typename T>
+constexpr bool is_bitwise_comparable_v = is_bitwise_comparable<T>::value;
+
+// uint_of_size_t<S> - the unsigned integer of S bytes, S of 1, 2, 4 or 8.
+template<size_t S>
+using uint_of_size_t = std::conditional_t<
+    S == 1, uint8_t, std::conditional_t<S == 2, uint16_t, std::conditional_t<S == 4, uint32_t, uint64_t>>>;
+
+template<size_t S>
+constexpr bool is_word_size_v = S == 1 || S == 2 || S == 4 || S == 8;
+
+// is_identity_hash_v<T> - std::hash<T>{}(v) is static_cast<size_t>(v), as the integers and the enums have it in
+//  libstdc++ and libc++: the hash can be computed from the bytes of the value.
+template<typename T>
+constexpr bool is_identity_hash_v =
+#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)
+    (std::is_integral_v<T> || std::is_enum_v<T>) && is_word_size_v<sizeof(T)>;
+#else
+    false;
+#endif
+
+// is_signed_value_v<T> - T, or the underlying type of the enum T, is signed.
+template<typename T>
+constexpr bool is_signed_value_v = std::is_signed_v<
+    typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>, std::type_identity<T>>::type>;
+
+template<typename T>
+struct af_strict_eq;
+
+template<size_t N, template<typename> class... Features>
+struct af_strict_eq<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    struct extend_properties
+    {
+        bool (*_strict_eq)(const A&, const A&){nullptr};
+    };
+    struct extend_cold_properties
+    {
+        size_t (*_strict_count_eq)(const A*, size_t, const A&){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto& prop)
+    {
+        static_assert(requires(T ta, T tb) { ta == tb; }, "af_strict_eq requires type supporting 'a == b' compare");
+
+        if constexpr (A::template is_inplace<T>() && is_bitwise_comparable_v<T> && is_word_size_v<sizeof(T)>)
+            prop._strict_eq = &bitwise_eq_value<sizeof(T)>;
+        else
+            prop._strict_eq = &strict_eq_value<T>;
+    }
+
+    // bitwise_eq_value<S> - the _strict_eq of all the in place bitwise comparable types of S bytes. operator== knows
+    //  these functions, and compares the S bytes of the storage inline instead of the indirect call.
+    template<size_t S>
+    static bool bitwise_eq_value(const A& a, const A& b) noexcept
+    {
+        uint_of_size_t<S> a_bits;
+        uint_of_size_t<S> b_bits;
+        std::memcpy(&a_bits, &a.template inplace_data<std::byte>(), S);
+        std::memcpy(&b_bits, &b.template inplace_data<std::byte>(), S);
+        return a_bits == b_bits;
+    }
+
+    // dispatch_eq - the bitwise compare inline when eq is one of the bitwise_eq_value, else the indirect call.
+    static bool dispatch_eq(bool (*eq)(const A&, const A&), const A& lhs, const A& rhs)
+    {
+        if (eq == &bitwise_eq_value<8>) return bitwise_eq_value<8>(lhs, rhs);
+        if (eq == &bitwise_eq_value<4>) return bitwise_eq_value<4>(lhs, rhs);
+        if (eq == &bitwise_eq_value<2>) return bitwise_eq_value<2>(lhs, rhs);
+        if (eq == &bitwise_eq_value<1>) return bitwise_eq_value<1>(lhs, rhs);
+        return eq(lhs, rhs);
+    }
+
+    template<typename T>
+    static bool strict_eq_value(const A& a, const A& b)
+    {
+        const T& a_value{a.template data<T>()};
+        const T& b_value{b.template data<T>()};
+        return a_value == b_value;
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        prop._strict_count_eq = &strict_count_eq_values<T>;
+    }
+
+    // strict_count_eq_values - how many of the n values are equal to value, which holds a T as well.
+    template<typename T>
+    static size_t strict_count_eq_values(const A* a, size_t n, const A& value)
+    {
+        const T& v{value.template data<T>()};
+        size_t   count{0};
+        for (size_t i{0}; i < n; ++i)
+        {
+            count += static_cast<size_t>(a[i].template data<T>() == v);
+        }
+        return count;
+    }
+
+    friend bool operator==(const A& lhs, const A& rhs)
+    {
+        if (lhs.has_value() && rhs.has_value())
+        {
+            if (lhs.properties() == rhs.properties())
+            {
+                if constexpr (A::closed_dispatch)
+                    return lhs.visit_type(
+                        [&]<typename T>(std::type_identity<T>) { return strict_eq_value<T>(lhs, rhs); });
+                else
+                    return dispatch_eq(lhs.properties()->_strict_eq, lhs, rhs);
+            }
             throw std::runtime_error("any operator eq '==': with different types");
         }
         throw std::runtime_error("empy ext::any in operator eq '=='");
@@ -885,12 +1831,86 @@ struct af_strict_inplace<any<N, Features...>>
     {
     };
     template<typename T>
-    static void construct_extend_properties(auto&)
+    static constexpr void construct_extend_properties(auto&)
         requires(A::template is_inplace<T>())
     {
     }
 };
 
+// hash_mix - the 64 bits finalizer of MurmurHash3, every input bit affects every output bit.
+constexpr uint64_t hash_mix(uint64_t h) noexcept
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+template<typename T>
+struct af_three_way;
+
+// af_three_way - operator<=>, a total order that does not throw: the empty any first, then by type (A::type_order,
+//  the fingerprint of the type, the same in every run and shared object), then by value with one indirect call,
+//  std::weak_order of the values (or synthesized from '<' and '=='). a < b, a == b, ... all come from the one <=>
+//  call, so std::sort on anys of mixed types needs no try/catch. With af_strict_less or af_strict_eq, their throwing
+//  '<' / '==' are used instead.
+template<size_t N, template<typename> class... Features>
+struct af_three_way<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    struct extend_properties
+    {
+        std::weak_ordering (*_three_way)(const A&, const A&){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto& prop)
+    {
+        static_assert(requires(const T& ta, const T& tb) { std::compare_weak_order_fallback(ta, tb); },
+                      "af_three_way requires type supporting 'a <=> b', or 'a < b' and 'a == b' compare");
+
+        prop._three_way = &three_way_value<T>;
+    }
+
+    template<typename T>
+    static std::weak_ordering three_way_value(const A& a, const A& b)
+    {
+        return std::compare_weak_order_fallback(a.template data<T>(), b.template data<T>());
+    }
+
+    friend std::weak_ordering operator<=>(const A& lhs, const A& rhs)
+    {
+        if (lhs.properties() == rhs.properties())
+        {
+            if (!lhs.has_value())
+                return std::weak_ordering::equivalent;
+            if constexpr (A::closed_dispatch)
+                return lhs.visit_type([&]<typename T>(std::type_identity<T>) { return three_way_value<T>(lhs, rhs); });
+            else
+                return lhs.properties()->_three_way(lhs, rhs);
+        }
+        if (!lhs.has_value() || !rhs.has_value())
+        {
+            return lhs.has_value() ? std::weak_ordering::greater : std::weak_ordering::less;
+        }
+        // the value compare of two properties of one type only, never of two types with the same fingerprint.
+        const auto by_type{A::type_order(lhs.properties(), rhs.properties())};
+        return by_type != 0 ? by_type : lhs.properties()->_three_way(lhs, rhs);
+    }
+
+    friend bool operator==(const A& lhs, const A& rhs)
+        requires(!std::is_base_of_v<af_strict_eq<A>, A>)
+    {
+        return (lhs <=> rhs) == 0;
+    }
+};
+
+template<typename T>
+struct af_mixed_hash;
+
 template<typename T>
 struct af_strict_hash;
 
@@ -903,16 +1923,84 @@ struct af_strict_hash<any<N, Features...>>
     {
         uint64_t (*_strict_hash)(const A&){nullptr};
     };
+    struct extend_cold_properties
+    {
+        void (*_strict_hash_n)(const A*, size_t, size_t*){nullptr};
+    };
 
     template<typename T>
-    static void construct_extend_properties(auto& prop)
+    static constexpr void construct_extend_properties(auto& prop)
     {
         static_assert(requires(T ta) { std::hash<T>{}(ta); }, "af_strict_hash requires type supporting hash{}(a)");
 
-        prop._strict_hash = +[](const A& a) -> uint64_t {
-            const T& value{a.template data<T>()};
-            return std::hash<T>{}(value);
-        };
+        if constexpr (A::template is_inplace<T>() && is_identity_hash_v<T> && !std::is_base_of_v<af_mixed_hash<A>, A>)
+            prop._strict_hash = &identity_hash_value<sizeof(T), is_signed_value_v<T>>;
+        else
+            prop._strict_hash = &strict_hash_value<T>;
+    }
+
+    // identity_hash_value<S, Signed> - the _strict_hash of the in place integers and enums of S bytes, whose
+    //  std::hash is the value: get_hash() knows these functions and loads the value inline, no indirect call.
+    //  Not with af_mixed_hash, the seed is of each type.
+    template<size_t S, bool Signed>
+    static uint64_t identity_hash_value(const A& a) noexcept
+    {
+        uint_of_size_t<S> bits;
+        std::memcpy(&bits, &a.template inplace_data<std::byte>(), S);
+        using signed_bits = std::make_signed_t<uint_of_size_t<S>>;
+        if constexpr (Signed)
+            return static_cast<uint64_t>(static_cast<int64_t>(static_cast<signed_bits>(bits)));
+        else
+            return bits;
+    }
+
+    // dispatch_hash - the hash inline when hash is one of the identity_hash_value, else the indirect call.
+    static uint64_t dispatch_hash(uint64_t (*hash)(const A&), const A& a)
+    {
+        if (hash == &identity_hash_value<8, true>) return identity_hash_value<8, true>(a);
+        if (hash == &identity_hash_value<8, false>) return identity_hash_value<8, false>(a);
+        if (hash == &identity_hash_value<4, true>) return identity_hash_value<4, true>(a);
+        if (hash == &identity_hash_value<4, false>) return identity_hash_value<4, false>(a);
+        return hash(a);
+    }
+
+    // hash_value<T> - the hash of an any holding a T equal to value, value may be of another type U with the same
+    //  std::hash (std::string_view for std::string). With af_mixed_hash, std::hash mixed with type_fingerprint<T>().
+    template<typename T, typename U = T>
+    static uint64_t hash_value(const U& value)
+    {
+        const uint64_t h{static_cast<uint64_t>(std::hash<U>{}(value))};
+        if constexpr (std::is_base_of_v<af_mixed_hash<A>, A>)
+        {
+            constexpr uint64_t seed{type_fingerprint<T>()};
+            return hash_mix(seed ^ h);
+        }
+        else
+        {
+            return h;
+        }
+    }
+
+    template<typename T>
+    static uint64_t strict_hash_value(const A& a)
+    {
+        const T& value{a.template data<T>()};
+        return hash_value<T>(value);
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        prop._strict_hash_n = &strict_hash_values<T>;
+    }
+
+    template<typename T>
+    static void strict_hash_values(const A* a, size_t n, size_t* out)
+    {
+        for (size_t i{0}; i < n; ++i)
+        {
+            out[i] = hash_value<T>(a[i].template data<T>());
+        }
     }
 
     [[nodiscard]] size_t get_hash() const
@@ -922,10 +2010,235 @@ struct af_strict_hash<any<N, Features...>>
         {
             throw std::runtime_error("hash on an empty ext::any");
         }
-        return self->properties()->_strict_hash(*self);
+        if constexpr (requires { self->cached_hash(); })
+        {
+            assert(self->cached_hash() == computed_hash(*self) &&
+                   "af_cached_hash: stale hash, call refresh_hash() after modifying the value in place");
+            return self->cached_hash();
+        }
+        else
+            return computed_hash(*self);
+    }
+
+private:
+    static size_t computed_hash(const A& a)
+    {
+        if constexpr (A::closed_dispatch)
+            return a.visit_type([&]<typename T>(std::type_identity<T>) { return strict_hash_value<T>(a); });
+        else
+            return dispatch_hash(a.properties()->_strict_hash, a);
     }
 };
 
+// af_mixed_hash - with af_strict_hash, get_hash() mixes std::hash<T> with type_fingerprint<T>() and a finalizer:
+//  int 1 and long 1 differ, and the identity std::hash of the integers spreads over all the bits, as open
+//  addressing tables need. The hash of a type is the same in every translation unit and shared object.
+template<size_t N, template<typename> class... Features>
+struct af_mixed_hash<any<N, Features...>>
+{
+    struct extend_properties
+    {
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+};
+
+// any_key_t<T> - the type an any holds for a key of type T: character strings are std::string.
+template<typename T>
+using any_key_t = std::conditional_t<!is_an_any_v<std::decay_t<T>> && std::is_convertible_v<const T&, std::string_view>,
+                                     std::string, std::decay_t<T>>;
+
+// any_hash / any_equal_to - transparent hash and equality for the unordered containers of an any A with
+//  af_strict_hash, they accept a plain key, a T or a std::string_view, without building a temporary any:
+//      std::unordered_map<A, V, ext::any_hash<A>, ext::any_equal_to<A>> m;  m.find(42);  m.find("key"sv);
+//  any_equal_to compares anys of different types as not equal (it needs af_strict_eq for the same type).
+template<typename A>
+struct any_hash
+{
+    using is_transparent = void;
+
+    size_t operator()(const A& a) const { return a.get_hash(); }
+
+    template<typename T>
+        requires(!is_an_any_v<std::decay_t<T>>)
+    size_t operator()(const T& value) const
+    {
+        using K = any_key_t<T>;
+        if constexpr (std::is_same_v<K, std::string>)
+        {
+            return af_strict_hash<A>::template hash_value<K>(std::string_view{value});
+        }
+        else
+        {
+            return af_strict_hash<A>::template hash_value<K>(value);
+        }
+    }
+};
+
+template<typename A>
+struct any_equal_to
+{
+    using is_transparent = void;
+
+    bool operator()(const A& a, const A& b) const
+    {
+        return a.properties() == b.properties() && (!a.has_value() || a == b);
+    }
+
+    template<typename T>
+        requires(!is_an_any_v<std::decay_t<T>>)
+    bool operator()(const A& a, const T& value) const
+    {
+        using K = any_key_t<T>;
+        return a.template holds<K>() && unchecked_any_cast<K>(a) == value;
+    }
+
+    template<typename T>
+        requires(!is_an_any_v<std::decay_t<T>>)
+    bool operator()(const T& value, const A& a) const
+    {
+        return (*this)(a, value);
+    }
+};
+
+// any_less - a total order on the anys of A with af_strict_less, that does not throw on mixed types: the empty any
+//  first, then by type (A::type_order, the order of af_three_way), then by value with operator<.
+//  Transparent like any_hash, a plain key T or a std::string_view is ordered as an any holding any_key_t<T>.
+template<typename A>
+struct any_less
+{
+    using is_transparent = void;
+
+    bool operator()(const A& a, const A& b) const
+    {
+        if (a.properties() == b.properties())
+        {
+            return a.has_value() && a < b;
+        }
+        if (!a.has_value() || !b.has_value())
+        {
+            return !a.has_value();
+        }
+        // the _strict_less of the type for one type only, its properties of two shared objects.
+        const auto by_type{A::type_order(a.properties(), b.properties())};
+        return by_type != 0 ? by_type < 0 : a.properties()->_strict_less(a, b);
+    }
+
+    template<typename T>
+        requires(!is_an_any_v<std::decay_t<T>>)
+    bool operator()(const A& a, const T& value) const
+    {
+        using K = any_key_t<T>;
+        if (a.template holds<K>())
+        {
+            return unchecked_any_cast<K>(a) < value;
+        }
+        return !a.has_value() || type_order_to<K>(a) < 0;
+    }
+
+    template<typename T>
+        requires(!is_an_any_v<std::decay_t<T>>)
+    bool operator()(const T& value, const A& a) const
+    {
+        using K = any_key_t<T>;
+        if (a.template holds<K>())
+        {
+            return value < unchecked_any_cast<K>(a);
+        }
+        return a.has_value() && type_order_to<K>(a) > 0;
+    }
+
+private:
+    // type_order_to<K> - the order of the value type of a, which is not K, against K.
+    template<typename K>
+    static std::weak_ordering type_order_to(const A& a) noexcept
+    {
+        if constexpr (A::closed_type_count() > 0 && A::template index_of<K>() == 0)
+        {
+            // not one of the closed types, K has no properties: after the types of its fingerprint.
+            const auto by_fingerprint{a.fingerprint() <=> type_fingerprint<K>()};
+            return by_fingerprint != 0 ? by_fingerprint : std::weak_ordering::less;
+        }
+        else
+        {
+            return A::type_order(a.properties(), A::template properties_of<K>());
+        }
+    }
+};
+
+template<typename T>
+struct af_cached_hash;
+
+// af_cached_hash - with af_strict_hash, the hash is computed once when a value is stored, and kept in the reserved
+//  tail of the storage, copied and moved with the value: get_hash() is a load, no call and no access to a heap value.
+//  Values modified in place, through any_cast<T>() references, need refresh_hash(): until then get_hash() returns
+//  the hash of the old value, and a hash table keyed on the any no longer finds it. Debug builds assert it.
+//  An any moved from keeps a correct hash: a moved-from value left in place is hashed again. When that hash throws
+//  (std::hash<T> need not be noexcept), the move does not: the cached hash stays the one of the value before the
+//  move, stale until refresh_hash().
+//  The storage grows by sizeof(size_t), any<16, af_strict_hash, af_cached_hash> is 32 bytes.
+template<size_t N, template<typename> class... Features>
+struct af_cached_hash<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    constexpr static size_t reserved_storage_size() { return sizeof(size_t); }
+
+    struct extend_properties
+    {
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static void on_value_stored(A& a)
+    {
+        static_assert(std::is_base_of_v<af_strict_hash<A>, A>, "af_cached_hash requires af_strict_hash");
+        store_hash(a, af_strict_hash<A>::template strict_hash_value<T>(a));
+    }
+
+    static void on_value_moved_from(A& a) noexcept
+    {
+        try
+        {
+            a.refresh_hash();
+        }
+        catch (...)
+        {
+            // the hash of the moved-from value is stale, as after a change in place.
+        }
+    }
+
+    [[nodiscard]] size_t cached_hash() const noexcept
+    {
+        size_t h;
+        std::memcpy(&h, static_cast<const A*>(this)->reserved_storage(), sizeof(h));
+        return h;
+    }
+
+    void refresh_hash()
+    {
+        auto self = static_cast<A*>(this);
+        if (self->has_value())
+        {
+            store_hash(*self, self->properties()->_strict_hash(*self));
+        }
+    }
+
+private:
+    static void store_hash(A& a, size_t h) noexcept { std::memcpy(a.reserved_storage(), &h, sizeof(h)); }
+};
+
+// af_variant<Ts...> - the any holds only one of Ts, its storage fits all of them. With at most 15 types the
+//  life cycle and the Features operations are a switch on the type index instead of indirect calls, and
+//  ext::visit(f, a) is available.
+//  Usage: ext::any<16, ext::af_variant<int, double, std::string>::template types, ext::af_strict_less>
 template<typename... Ts>
 struct af_variant
 {
@@ -935,7 +2248,8 @@ struct af_variant
     template<size_t N, template<typename> class... Features>
     struct types<any<N, Features...>>
     {
-        using A = any<N, Features...>;
+        using A            = any<N, Features...>;
+        using closed_types = std::tuple<Ts...>;
 
         constexpr static size_t min_required_size() { return std::max({(size_t)0, sizeof(Ts)...}); }
 
@@ -944,13 +2258,33 @@ struct af_variant
         };
 
         template<typename T>
-        static void construct_extend_properties(auto&)
+        static constexpr void construct_extend_properties(auto&)
         {
             static_assert(std::disjunction_v<std::is_same<T, Ts>...>, "af_variant requires specific types");
         }
     };
 };
 
+// overloaded - a set of lambdas as one visitor: ext::visit(ext::overloaded{[](int) {}, [](auto&) {}}, a)
+template<typename... Fs>
+struct overloaded : Fs...
+{
+    using Fs::operator()...;
+};
+
+// visit - calls f with the value stored in a, an any with a closed type set (af_variant), like std::visit.
+//  Throws bad_any_cast when a is empty.
+template<typename F, typename AT>
+    requires is_an_any_v<std::remove_cvref_t<AT>>
+constexpr decltype(auto) visit(F&& f, AT&& a)
+{
+    if (!a.has_value())
+    {
+        throw std::bad_any_cast{};
+    }
+    return a.visit_type([&]<typename T>(std::type_identity<T>) -> decltype(auto) { return f(a.template data<T>()); });
+}
+
 template<typename T>
 struct af_func;
 
@@ -983,16 +2317,44 @@ struct af_strict_add<any<N, Features...>>
     using A = any<N, Features...>;
 
     struct extend_properties
+    {
+    };
+    struct extend_cold_properties
     {
         A (*_strict_add)(const A&, const A&){nullptr};
+        A (*_strict_sum_n)(const A*, size_t){nullptr};
     };
 
     template<typename T>
-    static void construct_extend_properties(auto& prop)
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
     {
         static_assert(requires(T ta) { std::hash<T>{}(ta); }, "af_strict_hash requires type supporting hash{}(a)");
 
-        prop._strict_add = +[](const A& a, const A& b) -> A { return A(a.template data<T>() + b.template data<T>()); };
+        prop._strict_add   = &strict_add_value<T>;
+        prop._strict_sum_n = &strict_sum_values<T>;
+    }
+
+    // strict_sum_values - a[0] + a[1] + ... + a[n-1], n > 0.
+    template<typename T>
+    static A strict_sum_values(const A* a, size_t n)
+    {
+        T sum{a[0].template data<T>()};
+        for (size_t i{1}; i < n; ++i)
+        {
+            sum = sum + a[i].template data<T>();
+        }
+        return A(std::move(sum));
+    }
+
+    template<typename T>
+    static A strict_add_value(const A& a, const A& b)
+    {
+        return A(a.template data<T>() + b.template data<T>());
     }
 
     friend A operator+(const A& a, const A& b)
@@ -1002,7 +2364,301 @@ struct af_strict_add<any<N, Features...>>
         {
             throw std::runtime_error("operator+ ext::any without value or different types");
         }
-        return a.properties()->_strict_add(a, b);
+        if constexpr (A::closed_dispatch)
+            return a.visit_type([&]<typename T>(std::type_identity<T>) { return strict_add_value<T>(a, b); });
+        else
+            return a.cold_properties()->_strict_add(a, b);
+    }
+};
+
+// af_compact - compact layout: instead of the 8 bytes properties pointer, the any keeps a 32 bit index into a
+//  dense registry of the value types of its any type, after the storage. Every feature works the same, the
+//  properties are one more load away (the registry slot).
+//  sizeof(any<N, af_compact>) is N + 4 rounded up to 8: any<4, af_compact> is 8 bytes, any<12, af_compact> 16.
+//  With N < 8 the storage cannot hold a heap pointer, every value must be stored in place.
+//  A value type is registered when it is first stored or given to a type_handle, up to max_compact_types types per
+//  any type, past it these throw std::length_error. holds<T>() does not register T.
+template<typename T>
+struct af_compact;
+
+template<size_t N, template<typename> class... Features>
+struct af_compact<any<N, Features...>>
+{
+    static constexpr bool compact_layout{true};
+
+    struct extend_properties
+    {
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+};
+
+static_assert(sizeof(any<4, af_compact>) == 8, "wrong storage for compact any");
+static_assert(sizeof(any<12, af_compact>) == 16, "wrong storage for compact any");
+
+// af_allocator<Alloc> - values that do not fit in place are allocated with Alloc (rebound to the value type)
+//  instead of the global new/delete, e.g. an arena or a per-thread pool.
+//  Alloc is default constructed for every allocation and deallocation, so it must be stateless or refer to
+//  shared state (std::pmr::polymorphic_allocator with the default resource, a static arena, ...).
+//  Usage: ext::any<16, ext::af_allocator<my_arena_allocator<char>>::template feature>
+template<typename Alloc>
+struct af_allocator
+{
+    template<typename T>
+    struct feature;
+
+    template<size_t N, template<typename> class... Features>
+    struct feature<any<N, Features...>>
+    {
+        using A = any<N, Features...>;
+
+        struct extend_properties
+        {
+        };
+
+        template<typename T>
+        static constexpr void construct_extend_properties(auto&)
+        {
+        }
+
+        template<typename T>
+        using traits = typename std::allocator_traits<Alloc>::template rebind_traits<T>;
+
+        template<typename T>
+        static T* heap_allocate()
+        {
+            static_assert(std::is_same_v<typename traits<T>::pointer, T*>, "af_allocator requires raw pointers");
+            typename traits<T>::allocator_type alloc{};
+            return traits<T>::allocate(alloc, 1);
+        }
+
+        template<typename T>
+        static void heap_deallocate(T* p) noexcept
+        {
+            typename traits<T>::allocator_type alloc{};
+            traits<T>::deallocate(alloc, p, 1);
+        }
+    };
+};
+
+// any_pool - thread local, size class segregated free lists for the values which do not fit in place.
+//  Blocks are carved from slab_size aligned slabs, the slab header records the owning thread cache and the block size.
+//  A block freed by its owner thread goes back to the owner's local free list, a block freed by another thread is
+//  pushed to the owner's lock-free remote list, and drained by the owner when its local list runs empty.
+//  The cache of an exiting thread is kept as an orphan and adopted by the next thread, slabs are never released.
+//  The values allocated by the thread_local destructors run after it, in the exiting thread, come from a shared exit
+//  cache under a mutex.
+class any_pool
+{
+public:
+    static constexpr size_t slab_size{64 * 1024};
+    static constexpr size_t granularity{16};
+    static constexpr size_t max_block_size{256};
+    static constexpr size_t size_classes{max_block_size / granularity};
+
+    template<typename T>
+    static constexpr bool is_pooled{sizeof(T) <= max_block_size && alignof(T) <= granularity};
+
+    static void* allocate(size_t size)
+    {
+        const size_t sc{size_class(size)};
+        if (thread_cache* cache{local_cache()}) [[likely]]
+        {
+            return cache->allocate(sc);
+        }
+        const std::lock_guard lock{_exit_mutex};
+        return exit_cache().allocate(sc);
+    }
+
+    static void deallocate(void* p) noexcept
+    {
+        auto* block{static_cast<free_block*>(p)};
+        slab_header* slab{slab_of(p)};
+        if (slab->_owner == _current) [[likely]]
+        {
+            const size_t sc{size_class(slab->_block_size)};
+            block->_next        = _current->_free[sc];
+            _current->_free[sc] = block;
+            return;
+        }
+        std::atomic<free_block*>& remote{slab->_owner->_remote};
+        block->_next = remote.load(std::memory_order_relaxed);
+        while (!remote.compare_exchange_weak(block->_next, block, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+private:
+    struct free_block
+    {
+        free_block* _next;
+    };
+    struct thread_cache;
+    struct alignas(64) slab_header
+    {
+        thread_cache* _owner;
+        size_t        _block_size;
+    };
+
+    struct alignas(64) thread_cache
+    {
+        free_block*   _free[size_classes]{};
+        std::byte*    _bump[size_classes]{};
+        std::byte*    _bump_end[size_classes]{};
+        thread_cache* _next_orphan{nullptr};
+
+        alignas(64) std::atomic<free_block*> _remote{nullptr};
+
+        void* allocate(size_t sc)
+        {
+            if (!_free[sc]) [[unlikely]]
+            {
+                drain_remote();
+                if (!_free[sc]) return carve(sc);
+            }
+            free_block* block{_free[sc]};
+            _free[sc] = block->_next;
+            return block;
+        }
+
+        void drain_remote() noexcept
+        {
+            free_block* block{_remote.exchange(nullptr, std::memory_order_acquire)};
+            while (block)
+            {
+                free_block*  next{block->_next};
+                const size_t sc{size_class(slab_of(block)->_block_size)};
+                block->_next = _free[sc];
+                _free[sc]    = block;
+                block        = next;
+            }
+        }
+
+        void* carve(size_t sc)
+        {
+            const size_t block_size{(sc + 1) * granularity};
+            if (!_bump[sc] || static_cast<size_t>(_bump_end[sc] - _bump[sc]) < block_size)
+            {
+                auto* slab{static_cast<std::byte*>(::operator new(slab_size, std::align_val_t{slab_size}))};
+                new (slab) slab_header{this, block_size};
+                _bump[sc]     = slab + sizeof(slab_header);
+                _bump_end[sc] = slab + slab_size;
+            }
+            void* p{_bump[sc]};
+            _bump[sc] += block_size;
+            return p;
+        }
+    };
+
+    struct thread_cache_owner
+    {
+        thread_cache* _cache{adopt()};
+
+        thread_cache_owner() { _current = _cache; }
+        thread_cache_owner(const thread_cache_owner&)            = delete;
+        thread_cache_owner& operator=(const thread_cache_owner&) = delete;
+        // The cache is handed to the next thread: from now on this thread allocates from the exit cache, and
+        //  frees to the remote list of its former cache, as any other thread.
+        ~thread_cache_owner()
+        {
+            _current = nullptr;
+            _exited  = true;
+            const std::lock_guard lock{_orphans_mutex};
+            _cache->_next_orphan = _orphans;
+            _orphans             = _cache;
+        }
+    };
+
+    static constexpr size_t size_class(size_t size) noexcept { return (size + granularity - 1) / granularity - 1; }
+
+    static slab_header* slab_of(void* p) noexcept
+    {
+        return std::bit_cast<slab_header*>(std::bit_cast<uintptr_t>(p) & ~(uintptr_t{slab_size} - 1));
+    }
+
+    static thread_cache* adopt()
+    {
+        const std::lock_guard lock{_orphans_mutex};
+        if (thread_cache* cache{_orphans})
+        {
+            _orphans            = cache->_next_orphan;
+            cache->_next_orphan = nullptr;
+            return cache;
+        }
+        return new thread_cache{};
+    }
+
+    // exit_cache - owned by no thread, it allocates under _exit_mutex.
+    static thread_cache& exit_cache() noexcept
+    {
+        static constinit thread_cache cache{};
+        return cache;
+    }
+
+    // local_cache - the cache of this thread, nullptr once its owner is destroyed at the thread exit.
+    static thread_cache* local_cache()
+    {
+        if (_current) [[likely]]
+            return _current;
+        if (_exited)
+            return nullptr;
+        thread_local thread_cache_owner owner{};
+        return owner._cache;
+    }
+
+    static inline thread_local constinit thread_cache* _current{nullptr};
+    static inline thread_local constinit bool          _exited{false};
+    static inline std::mutex                           _orphans_mutex{};
+    static inline thread_cache*                        _orphans{nullptr};
+    static inline std::mutex                           _exit_mutex{};
+};
+
+// af_pooled - values that do not fit in place and are up to any_pool::max_block_size bytes are allocated from
+//  the thread local any_pool size classes, larger or over aligned values use the global heap.
+template<typename T>
+struct af_pooled;
+
+template<size_t N, template<typename> class... Features>
+struct af_pooled<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    struct extend_properties
+    {
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static T* heap_allocate()
+    {
+        if constexpr (any_pool::is_pooled<T>)
+        {
+            return static_cast<T*>(any_pool::allocate(sizeof(T)));
+        }
+        else
+        {
+            return std::allocator<T>{}.allocate(1);
+        }
+    }
+
+    template<typename T>
+    static void heap_deallocate(T* p) noexcept
+    {
+        if constexpr (any_pool::is_pooled<T>)
+        {
+            any_pool::deallocate(p);
+        }
+        else
+        {
+            std::allocator<T>{}.deallocate(p, 1);
+        }
     }
 };
 
@@ -1015,4 +2671,37 @@ struct hash<ext::any<N, Features...>>
     size_t operator()(const ext::any<N, Features...>& x) const { return x.get_hash(); }
 };
 
+#if defined(__cpp_lib_format)
+// formatter<ext::any> - for anys with af_formatted. The spec of the replacement field is kept as is: it is parsed by
+//  the formatter of the stored type, known only when the value is formatted, with no access to the arguments. A
+//  nested replacement field ({:{}} or {:{1}}, a width or precision from an argument) throws std::format_error.
+template<size_t N, template<typename> class... Features>
+    requires std::is_base_of_v<ext::af_formatted<ext::any<N, Features...>>, ext::any<N, Features...>>
+struct formatter<ext::any<N, Features...>, char>
+{
+    constexpr format_parse_context::iterator parse(format_parse_context& ctx)
+    {
+        auto it{ctx.begin()};
+        while (it != ctx.end() && *it != '}')
+        {
+            if (*it == '{')
+            {
+                throw format_error("ext::any: nested replacement fields are not supported in the format spec");
+            }
+            ++it;
+        }
+        _spec = string_view{ctx.begin(), it};
+        return it;
+    }
+
+    format_context::iterator format(const ext::any<N, Features...>& a, format_context& ctx) const
+    {
+        return ext::af_formatted<ext::any<N, Features...>>::format(a, _spec, ctx);
+    }
+
+private:
+    string_view _spec;
+};
+#endif
+
 }  // namespace std
@@ -0,0 +1,189 @@
+#pragma once
+
+// clang-format off
+// Algorithms over ranges of ext::any, which visit the elements grouped by value type.
+// Visiting a mixed type range in order makes every feature operation (operator<<, operator<, get_hash, ...) an
+// indirect call to a different target, which the branch predictor misses. Grouped by type, each batch calls one
+// target only, or a typed loop with no indirect call at all.
+// clang-format on
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "any.h"
+
+namespace ext {
+
+// prefetch_distance - how many elements ahead the heap stored values are prefetched.
+constexpr size_t prefetch_distance{8};
+
+inline void prefetch_value(const void* p) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// any_batch - the elements of a range with the same value type (the same properties), in range order.
+//  Given to the visitor of for_each_batched, which picks a typed loop (for_each<T>) or a loop on the anys.
+template<typename R>
+class any_batch
+{
+public:
+    using reference = std::ranges::range_reference_t<R>;
+    using A         = std::remove_cvref_t<reference>;
+    static_assert(is_an_any_v<A>, "any_batch requires a range of ext::any");
+
+    any_batch(R& range, const typename A::any_properties* properties, const uint32_t* indices, size_t n) noexcept
+        : _range(range), _properties(properties), _indices(indices), _size(n)
+    {
+    }
+
+    // properties - the properties of the values of the batch, nullptr for the empty anys.
+    [[nodiscard]] const typename A::any_properties* properties() const noexcept { return _properties; }
+    [[nodiscard]] size_t                            size() const noexcept { return _size; }
+    // index - the position in the range of the k-th element of the batch.
+    [[nodiscard]] size_t    index(size_t k) const noexcept { return _indices[k]; }
+    [[nodiscard]] reference operator[](size_t k) const { return std::ranges::begin(_range)[_indices[k]]; }
+
+    template<typename T>
+    [[nodiscard]] bool holds() const noexcept
+    {
+        return _size > 0 && (*this)[0].template holds<T>();
+    }
+
+    // for_each - f(a) on each any of the batch, the feature operations in f all call the same target.
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t k{0}; k < _size; ++k)
+        {
+            prefetch_ahead(k);
+            f((*this)[k]);
+        }
+    }
+
+    // for_each<T> - f(value) on each value of the batch, the batch must hold T: a typed loop, no indirect call.
+    template<typename T, typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t k{0}; k < _size; ++k)
+        {
+            if constexpr (!A::template is_inplace<T>())
+            {
+                prefetch_ahead(k);
+            }
+            f(unchecked_any_cast<T>((*this)[k]));
+        }
+    }
+
+private:
+    void prefetch_ahead(size_t k) const noexcept
+    {
+        if (k + prefetch_distance < _size)
+        {
+            const A& a{(*this)[k + prefetch_distance]};
+            if (!a.inplace())
+            {
+                prefetch_value(a.template get_pointer<void>());
+            }
+        }
+    }
+
+    R&                                _range;
+    const typename A::any_properties* _properties;
+    const uint32_t*                   _indices;
+    size_t                            _size;
+};
+
+// for_each_batched(range, visitor) - calls visitor(batch) once per value type of the range, with an any_batch of
+//  the elements of that type. The element positions are grouped with a stable counting sort on the properties,
+//  kept as uint32_t: a range of more than UINT32_MAX elements throws std::length_error.
+//      ext::for_each_batched(v, [&](const auto& batch) {
+//          if (batch.template holds<int>()) batch.template for_each<int>([&](int x) { sum += x; });
+//          else batch.for_each([&](const auto& a) { std::cout << a << '\n'; });
+//      });
+template<std::ranges::random_access_range R, typename Visitor>
+    requires std::ranges::sized_range<R>
+void for_each_batched(R&& range, Visitor&& visitor)
+{
+    using A = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+    static_assert(is_an_any_v<A>, "for_each_batched requires a range of ext::any");
+    using properties_ptr = const typename A::any_properties*;
+
+    const size_t n{static_cast<size_t>(std::ranges::size(range))};
+    if (n > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::length_error("ext::for_each_batched: more than UINT32_MAX elements");
+    }
+    auto first{std::ranges::begin(range)};
+
+    // the batch of each element, and the size of each batch.
+    std::vector<properties_ptr> batch_properties;
+    std::vector<uint32_t>       batch_of(n);
+    std::vector<uint32_t>       offsets;
+    uint32_t                    last{0};
+    for (size_t i{0}; i < n; ++i)
+    {
+        const properties_ptr p{first[static_cast<std::ranges::range_difference_t<R>>(i)].properties()};
+        if (last >= batch_properties.size() || batch_properties[last] != p)
+        {
+            last = 0;
+            while (last < batch_properties.size() && batch_properties[last] != p) ++last;
+            if (last == batch_properties.size())
+            {
+                batch_properties.push_back(p);
+                offsets.push_back(0);
+            }
+        }
+        batch_of[i] = last;
+        ++offsets[last];
+    }
+
+    // exclusive prefix sum, then a stable scatter of the positions.
+    uint32_t sum{0};
+    for (auto& o : offsets)
+    {
+        const uint32_t count{o};
+        o = sum;
+        sum += count;
+    }
+    std::vector<uint32_t> indices(n);
+    std::vector<uint32_t> next(offsets);
+    for (size_t i{0}; i < n; ++i)
+    {
+        indices[next[batch_of[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    for (size_t b{0}; b < batch_properties.size(); ++b)
+    {
+        const uint32_t begin{offsets[b]};
+        const uint32_t end{b + 1 < offsets.size() ? offsets[b + 1] : static_cast<uint32_t>(n)};
+        visitor(any_batch<std::remove_reference_t<R>>{range, batch_properties[b], indices.data() + begin, end - begin});
+    }
+}
+
+// for_each_batched<Ts...>(range, f) - f(value) with a typed loop for the values of the types Ts, f(a) on the
+//  any for the values of the other types and the empty anys, batch by batch.
+template<typename... Ts, std::ranges::random_access_range R, typename F>
+    requires(sizeof...(Ts) > 0 && std::ranges::sized_range<R>)
+void for_each_batched(R&& range, F&& f)
+{
+    for_each_batched(range, [&](const auto& batch) {
+        const bool typed{(false || ... || (batch.template holds<Ts>() && (batch.template for_each<Ts>(f), true)))};
+        if (!typed)
+        {
+            batch.for_each(f);
+        }
+    });
+}
+
+}  // namespace ext
@@ -0,0 +1,326 @@
+#pragma once
+
+// clang-format off
+// any_archive - an on disk array of ext::any values, read in place from a memory mapping.
+// write_archive(os, values) writes the af_serialize records of the values, then the table of their types and the
+// index of the records. any_archive_view<A> over the bytes of an archive (a mapped_file) opens it in constant time,
+// whatever its size: view[i] refers to the record i in the bytes, get<T>() of a bytewise serialized value (see
+// is_bitwise_serializable<T>) is the value in the mapping, no copy and no allocation, load() builds the any.
+//
+// Layout, every part 8 bytes aligned, the offsets are from the first byte of the archive:
+//      any_archive_header                  - magic, version.
+//      records                             - the af_serialize records of the values.
+//      uint64_t types[type_count]          - the type ids of the values, 0 for the empty any.
+//      uint64_t index[count]               - the offset of the record i | its position in types << 48.
+//      any_archive_trailer                 - count, type_count, the offsets of types and index, magic.
+// The archive is written in one pass, the output stream does not seek. Like the records, it is in the native byte
+// order and its type ids depend on the compiler.
+// clang-format on
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "any_serialize.h"
+
+namespace ext {
+
+constexpr char     archive_magic[8]{'e', 'x', 't', 'a', 'n', 'y', '\0', '\1'};
+constexpr uint32_t archive_version{1};
+
+struct any_archive_header
+{
+    char     magic[8]{};
+    uint32_t version{0};
+    uint32_t reserved{0};
+};
+static_assert(sizeof(any_archive_header) == 16);
+
+struct any_archive_trailer
+{
+    uint64_t count{0};
+    uint64_t types_offset{0};
+    uint64_t index_offset{0};
+    uint32_t type_count{0};
+    uint32_t reserved{0};
+    char     magic[8]{};
+};
+static_assert(sizeof(any_archive_trailer) == 40);
+
+// An index entry: the record offset in the low 48 bits, the position of its type in the type table above.
+constexpr unsigned archive_type_shift{48};
+constexpr uint64_t archive_offset_mask{(uint64_t{1} << archive_type_shift) - 1};
+constexpr size_t   archive_max_types{size_t{1} << (64 - archive_type_shift)};
+
+// write_archive(os, values) - writes the archive of a range of anys with af_serialize, returns its size in bytes.
+//  Throws std::runtime_error when the stream fails, std::length_error past 65536 value types or 256 TiB.
+template<std::ranges::input_range R>
+size_t write_archive(std::ostream& os, const R& values)
+{
+    constexpr size_t       chunk_size{size_t{1} << 20};
+    std::vector<std::byte> chunk;
+    std::vector<uint64_t>  types;
+    std::vector<uint64_t>  index;
+    uint64_t               written{0};
+
+    const auto write = [&](const void* p, size_t size) {
+        os.write(static_cast<const char*>(p), static_cast<std::streamsize>(size));
+        written += size;
+    };
+    const auto flush = [&] {
+        write(chunk.data(), chunk.size());
+        chunk.clear();
+    };
+
+    any_archive_header header{};
+    std::memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.version = archive_version;
+    write(&header, sizeof(header));
+
+    chunk.reserve(chunk_size);
+    uint64_t last_type{~uint64_t{0}};
+    uint64_t slot{0};
+    for (const auto& a : values)
+    {
+        const uint64_t type_id{a.fingerprint()};
+        if (type_id != last_type)
+        {
+            slot = static_cast<uint64_t>(std::ranges::find(types, type_id) - types.begin());
+            if (slot == types.size())
+            {
+                if (types.size() == archive_max_types)
+                {
+                    throw std::length_error("ext::write_archive: too many value types");
+                }
+                types.push_back(type_id);
+            }
+            last_type = type_id;
+        }
+        const uint64_t offset{written + chunk.size()};
+        if (offset > archive_offset_mask)
+        {
+            throw std::length_error("ext::write_archive: archive larger than 256 TiB");
+        }
+        index.push_back(offset | slot << archive_type_shift);
+
+        const size_t used{chunk.size()};
+        chunk.resize(used + a.serialized_size());
+        a.serialize(std::span<std::byte>{chunk}.subspan(used));
+        if (chunk.size() >= chunk_size)
+        {
+            flush();
+        }
+    }
+    flush();
+
+    any_archive_trailer trailer{};
+    trailer.count        = index.size();
+    trailer.types_offset = written;
+    trailer.index_offset = written + types.size() * sizeof(uint64_t);
+    trailer.type_count   = static_cast<uint32_t>(types.size());
+    std::memcpy(trailer.magic, archive_magic, sizeof(archive_magic));
+    write(types.data(), types.size() * sizeof(uint64_t));
+    write(index.data(), index.size() * sizeof(uint64_t));
+    write(&trailer, sizeof(trailer));
+    if (!os)
+    {
+        throw std::runtime_error("ext::write_archive: write failed");
+    }
+    return written;
+}
+
+// any_archive_view<A> - the values of an archive, read in place.
+//      ext::mapped_file file{"prices.anys"};
+//      ext::any_archive_view<A> view{file.bytes(), registry};
+//      for (size_t i{0}; i < view.size(); ++i) if (auto* p = view[i].get_if<double>()) sum += *p;
+// The constructor checks the header, the trailer and the type table, a record is checked when it is accessed.
+// Both throw std::runtime_error on an invalid archive. The bytes (8 bytes aligned, as a mapping is) and the
+// registry must outlive the view.
+template<typename A>
+class any_archive_view
+{
+public:
+    using reference = any_record_ref<A>;
+
+    any_archive_view(std::span<const std::byte> bytes, const any_registry<A>& registry) : _registry{&registry}
+    {
+        if (reinterpret_cast<uintptr_t>(bytes.data()) % record_alignment)
+        {
+            throw std::invalid_argument("ext::any_archive_view: bytes not 8 bytes aligned");
+        }
+        if (bytes.size() < sizeof(any_archive_header) + sizeof(any_archive_trailer))
+        {
+            invalid();
+        }
+        any_archive_header  header;
+        any_archive_trailer trailer;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+        if (std::memcmp(header.magic, archive_magic, sizeof(archive_magic)) ||
+            std::memcmp(trailer.magic, archive_magic, sizeof(archive_magic)) || header.version != archive_version)
+        {
+            invalid();
+        }
+        const uint64_t end{bytes.size() - sizeof(trailer)};
+        if (trailer.types_offset < sizeof(header) || trailer.types_offset % record_alignment ||
+            trailer.types_offset > end || trailer.type_count > (end - trailer.types_offset) / sizeof(uint64_t) ||
+            trailer.index_offset != trailer.types_offset + trailer.type_count * sizeof(uint64_t) ||
+            trailer.count != (end - trailer.index_offset) / sizeof(uint64_t) ||
+            (end - trailer.index_offset) % sizeof(uint64_t))
+        {
+            invalid();
+        }
+
+        _bytes       = bytes.data();
+        _records_end = trailer.types_offset;
+        _index       = bytes.data() + trailer.index_offset;
+        _count       = trailer.count;
+        _types.reserve(trailer.type_count);
+        for (uint32_t t{0}; t < trailer.type_count; ++t)
+        {
+            uint64_t id;
+            std::memcpy(&id, bytes.data() + trailer.types_offset + t * sizeof(uint64_t), sizeof(id));
+            _types.push_back(type_entry{id, registry.properties(id)});
+        }
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return _count; }
+    [[nodiscard]] bool   empty() const noexcept { return _count == 0; }
+
+    // operator[] - the record i, i < size().
+    [[nodiscard]] reference operator[](size_t i) const
+    {
+        uint64_t entry;
+        std::memcpy(&entry, _index + i * sizeof(uint64_t), sizeof(entry));
+        const uint64_t offset{entry & archive_offset_mask};
+        const uint64_t slot{entry >> archive_type_shift};
+        if (offset < sizeof(any_archive_header) || offset % record_alignment ||
+            offset > _records_end - sizeof(any_record_header) || slot >= _types.size())
+        {
+            invalid();
+        }
+        any_record_header header;
+        std::memcpy(&header, _bytes + offset, sizeof(header));
+        if (header.type_id != _types[slot].type_id || record_size(header.size) > _records_end - offset)
+        {
+            invalid();
+        }
+        return reference{_bytes + offset, header.size, _types[slot].properties, _registry};
+    }
+
+    [[nodiscard]] reference at(size_t i) const
+    {
+        if (i >= _count)
+        {
+            throw std::out_of_range("ext::any_archive_view::at");
+        }
+        return (*this)[i];
+    }
+
+private:
+    struct type_entry
+    {
+        uint64_t                          type_id;
+        const typename A::any_properties* properties;
+    };
+
+    [[noreturn]] static void invalid() { throw std::runtime_error("ext::any_archive_view: invalid archive"); }
+
+    const any_registry<A>*  _registry;
+    const std::byte*        _bytes{nullptr};
+    const std::byte*        _index{nullptr};
+    uint64_t                _records_end{0};
+    size_t                  _count{0};
+    std::vector<type_entry> _types;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// mapped_file - a file mapped read only, its pages are read on first access. Throws std::system_error when the file
+//  cannot be opened or mapped.
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::filesystem::path& path)
+    {
+        const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "ext::mapped_file: open " + path.string());
+        }
+        struct stat st{};
+        const bool  stat_ok{::fstat(fd, &st) == 0};
+        void*       p{MAP_FAILED};
+        if (stat_ok && st.st_size > 0)
+        {
+            p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        const int error{errno};
+        ::close(fd);
+        if (!stat_ok || (st.st_size > 0 && p == MAP_FAILED))
+        {
+            throw std::system_error(error, std::generic_category(), "ext::mapped_file: map " + path.string());
+        }
+        if (p != MAP_FAILED)
+        {
+            _data = p;
+            _size = static_cast<size_t>(st.st_size);
+        }
+    }
+
+    mapped_file(const mapped_file&)            = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& rhs) noexcept
+        : _data{std::exchange(rhs._data, nullptr)}, _size{std::exchange(rhs._size, 0)}
+    {
+    }
+    mapped_file& operator=(mapped_file&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            unmap();
+            _data = std::exchange(rhs._data, nullptr);
+            _size = std::exchange(rhs._size, 0);
+        }
+        return *this;
+    }
+    ~mapped_file() { unmap(); }
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept
+    {
+        return {static_cast<const std::byte*>(_data), _size};
+    }
+
+private:
+    void unmap() noexcept
+    {
+        if (_data)
+        {
+            ::munmap(_data, _size);
+        }
+    }
+
+    void*  _data{nullptr};
+    size_t _size{0};
+};
+#endif
+
+}  // namespace ext
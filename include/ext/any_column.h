@@ -0,0 +1,234 @@
+#pragma once
+
+// clang-format off
+// any_column<A> - a column of ext::any values grouped by value type.
+// The values of one type are kept together in a run, contiguous anys of the same properties, so a bulk operation
+// is one call per run into a typed loop (the *_n batch operations of the properties), instead of an unpredictable
+// indirect call per element. Each element keeps its logical index, the position it was appended at.
+// clang-format on
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "any.h"
+
+namespace ext {
+
+template<typename A>
+class any_column
+{
+public:
+    using value_type = A;
+
+    // run - the values of one type, values[k] is the element of logical index logical[k].
+    struct run
+    {
+        const typename A::any_properties* properties{nullptr};
+        std::vector<A>                    values;
+        std::vector<uint32_t>             logical;
+    };
+
+    any_column() = default;
+    any_column(const any_column&)            = default;
+    any_column(any_column&&) noexcept        = default;
+    any_column& operator=(const any_column&) = default;
+    any_column& operator=(any_column&&)      = default;
+    ~any_column() { clear(); }
+
+    [[nodiscard]] size_t size() const noexcept { return _index.size(); }
+    [[nodiscard]] bool   empty() const noexcept { return _index.empty(); }
+    [[nodiscard]] static constexpr size_t max_size() noexcept { return UINT32_MAX; }
+    [[nodiscard]] const std::vector<run>& runs() const noexcept { return _runs; }
+
+    // push_back - appends the value, returns its logical index. Empty anys are kept in their own run.
+    size_t push_back(const A& value) { return append(A{value}); }
+    size_t push_back(A&& value) { return append(std::move(value)); }
+
+    template<typename T, typename... Args>
+    size_t emplace_back(Args&&... args)
+    {
+        A value{};
+        value.template emplace<T>(std::forward<Args>(args)...);
+        return append(std::move(value));
+    }
+
+    [[nodiscard]] const A& operator[](size_t i) const noexcept
+    {
+        const auto [r, k] = _index[i];
+        return _runs[r].values[k];
+    }
+    [[nodiscard]] const A& at(size_t i) const
+    {
+        if (i >= size())
+        {
+            throw std::out_of_range("any_column::at");
+        }
+        return (*this)[i];
+    }
+
+    // set - replaces the value at logical index i, a value of another type moves to the run of that type.
+    void set(size_t i, A value)
+    {
+        auto [r, k] = _index.at(i);
+        if (_runs[r].properties == value.properties())
+        {
+            _runs[r].values[k] = std::move(value);
+            return;
+        }
+        remove_from_run(r, k);
+        const uint32_t nr{find_run(value.properties())};
+        _index[i] = {nr, static_cast<uint32_t>(_runs[nr].values.size())};
+        _runs[nr].values.push_back(std::move(value));
+        _runs[nr].logical.push_back(static_cast<uint32_t>(i));
+    }
+
+    // clear - destroys the values with one batch reset per run.
+    void clear() noexcept
+    {
+        for (auto& r : _runs)
+        {
+            if (r.properties && !r.values.empty())
+            {
+                r.properties->_cold->_reset_n(r.values.data(), r.values.size());
+            }
+        }
+        _runs.clear();
+        _index.clear();
+        _last_run = 0;
+    }
+
+    // hashes - get_hash() of every element, in logical order (af_strict_hash).
+    [[nodiscard]] std::vector<size_t> hashes() const
+        requires requires(const typename A::any_properties_cold& c) { c._strict_hash_n; }
+    {
+        std::vector<size_t> out(size());
+        std::vector<size_t> run_hashes;
+        for (const auto& r : _runs)
+        {
+            if (r.values.empty())
+            {
+                continue;  // a run emptied by set()
+            }
+            if (!r.properties)
+            {
+                throw std::runtime_error("hash on an empty ext::any");
+            }
+            run_hashes.resize(r.values.size());
+            r.properties->_cold->_strict_hash_n(r.values.data(), r.values.size(), run_hashes.data());
+            for (size_t k{0}; k < run_hashes.size(); ++k)
+            {
+                out[r.logical[k]] = run_hashes[k];
+            }
+        }
+        return out;
+    }
+
+    // count - the number of elements equal to value (af_strict_eq), only the run of its type is scanned.
+    [[nodiscard]] size_t count(const A& value) const
+        requires requires(const typename A::any_properties_cold& c) { c._strict_count_eq; }
+    {
+        if (!value.has_value())
+        {
+            throw std::runtime_error("empty ext::any in any_column::count");
+        }
+        for (const auto& r : _runs)
+        {
+            if (r.properties == value.properties())
+            {
+                return r.properties->_cold->_strict_count_eq(r.values.data(), r.values.size(), value);
+            }
+        }
+        return 0;
+    }
+
+    // sums - the sum of the values of each run (af_strict_add), in the order of runs().
+    [[nodiscard]] std::vector<A> sums() const
+        requires requires(const typename A::any_properties_cold& c) { c._strict_sum_n; }
+    {
+        std::vector<A> out;
+        out.reserve(_runs.size());
+        for (const auto& r : _runs)
+        {
+            if (r.properties && !r.values.empty())
+            {
+                out.push_back(r.properties->_cold->_strict_sum_n(r.values.data(), r.values.size()));
+            }
+        }
+        return out;
+    }
+
+    // write - streams the values run by run, separated by sep (af_streamed).
+    std::ostream& write(std::ostream& os, std::string_view sep = ", ") const
+        requires requires(const typename A::any_properties_cold& c) { c._ostream_n; }
+    {
+        bool first{true};
+        for (const auto& r : _runs)
+        {
+            if (!r.properties || r.values.empty())
+            {
+                continue;
+            }
+            if (!first) os << sep;
+            first = false;
+            r.properties->_cold->_ostream_n(os, r.values.data(), r.values.size(), sep);
+        }
+        return os;
+    }
+
+private:
+    size_t append(A&& value)
+    {
+        if (_index.size() == max_size())
+        {
+            throw std::length_error("any_column is full");
+        }
+        const uint32_t r{find_run(value.properties())};
+        const uint32_t i{static_cast<uint32_t>(_index.size())};
+        _index.emplace_back(r, static_cast<uint32_t>(_runs[r].values.size()));
+        _runs[r].values.push_back(std::move(value));
+        _runs[r].logical.push_back(i);
+        return i;
+    }
+
+    // find_run - the run of the properties, created when missing. Appends mostly hit the run of the previous one.
+    uint32_t find_run(const typename A::any_properties* properties)
+    {
+        if (_last_run < _runs.size() && _runs[_last_run].properties == properties)
+        {
+            return _last_run;
+        }
+        for (uint32_t r{0}; r < _runs.size(); ++r)
+        {
+            if (_runs[r].properties == properties)
+            {
+                return _last_run = r;
+            }
+        }
+        _runs.push_back(run{properties, {}, {}});
+        return _last_run = static_cast<uint32_t>(_runs.size() - 1);
+    }
+
+    // remove_from_run - the last value of the run takes the place of the removed one.
+    void remove_from_run(uint32_t r, uint32_t k)
+    {
+        auto& rn{_runs[r]};
+        if (k + 1 != rn.values.size())
+        {
+            rn.values[k]                 = std::move(rn.values.back());
+            rn.logical[k]                = rn.logical.back();
+            _index[rn.logical[k]].second = k;
+        }
+        rn.values.pop_back();
+        rn.logical.pop_back();
+    }
+
+    std::vector<run>                           _runs;
+    std::vector<std::pair<uint32_t, uint32_t>> _index;  // logical index -> (run, position in the run)
+    uint32_t                                   _last_run{0};
+};
+
+}  // namespace ext
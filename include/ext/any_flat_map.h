@@ -0,0 +1,455 @@
+#pragma once
+
+// clang-format off
+// any_flat_map<A, V> - open addressing hash map with ext::any keys, in the style of the SwissTable:
+// a control byte per slot (empty, deleted, or 7 bits of the hash), probed 16 at a time with SSE2 (a scalar loop
+// otherwise), and the key/value pairs stored inline in one array, no node allocation per entry.
+// Keys of different types are never equal: the properties are compared before the af_strict_eq call, so keys of
+// mixed types (and the empty any) do not throw. A requires af_strict_hash and af_strict_eq, with af_cached_hash
+// the hash of a stored key is not computed again on rehash.
+// Lookups accept a plain key (find(42), find("name"sv)) through any_hash / any_equal_to.
+// Like std::flat_map, the iterators give a std::pair<const A&, V&> of the slot: a key cannot be modified in place,
+// the slots themselves relocate. A rehash moves the elements, or copies them when the move of V may throw: a throw
+// leaves the map as it was.
+// clang-format on
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "any.h"
+
+namespace ext {
+
+template<typename A, typename V>
+class any_flat_map
+{
+    static_assert(std::is_nothrow_move_constructible_v<A>, "the move of an ext::any does not throw");
+    static_assert(std::is_nothrow_move_constructible_v<V> || std::is_copy_constructible_v<V>,
+                  "any_flat_map requires a value type with a non throwing move, or a copy");
+
+public:
+    using key_type    = A;
+    using mapped_type = V;
+    using value_type  = std::pair<A, V>;
+
+private:
+    static constexpr size_t  group_width{16};
+    static constexpr int8_t  ctrl_empty{-128};
+    static constexpr int8_t  ctrl_deleted{-2};
+    static constexpr size_t  max_load_num{7};  // grow at 7/8 full, counting the deleted slots.
+    static constexpr size_t  max_load_den{8};
+
+    // group - the 16 control bytes of a probe step, match() gives a bit per slot.
+    struct group
+    {
+        const int8_t* ctrl;
+
+#if defined(__SSE2__)
+        [[nodiscard]] uint32_t match(int8_t h2) const noexcept
+        {
+            const __m128i c{_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))};
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(h2))));
+        }
+        [[nodiscard]] uint32_t match_empty() const noexcept { return match(ctrl_empty); }
+        // match_free - empty or deleted, the control bytes with the high bit set.
+        [[nodiscard]] uint32_t match_free() const noexcept
+        {
+            const __m128i c{_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))};
+            return static_cast<uint32_t>(_mm_movemask_epi8(c));
+        }
+#else
+        [[nodiscard]] uint32_t match(int8_t h2) const noexcept
+        {
+            uint32_t m{0};
+            for (uint32_t i{0}; i < group_width; ++i) m |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+            return m;
+        }
+        [[nodiscard]] uint32_t match_empty() const noexcept { return match(ctrl_empty); }
+        [[nodiscard]] uint32_t match_free() const noexcept
+        {
+            uint32_t m{0};
+            for (uint32_t i{0}; i < group_width; ++i) m |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+            return m;
+        }
+#endif
+    };
+
+public:
+    template<bool Const>
+    class basic_iterator
+    {
+    public:
+        using map_type   = std::conditional_t<Const, const any_flat_map, any_flat_map>;
+        using value_type = any_flat_map::value_type;
+        using reference  = std::pair<const A&, std::conditional_t<Const, const V&, V&>>;
+        // the reference is a pair of references, not a value_type&: an input iterator for the pre-C++20
+        //  iterator_traits, like the iterators of std::flat_map and of the views. A std::forward_iterator from
+        //  C++23 (P2321), which gives the common reference of std::pair<const A&, V&> and std::pair<A, V>.
+        using difference_type   = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+#if defined(__cpp_lib_ranges_zip)
+        using iterator_concept = std::forward_iterator_tag;
+#endif
+
+        // pointer - the pair of references, for it->first / it->second.
+        struct pointer
+        {
+            reference                      ref;
+            [[nodiscard]] const reference* operator->() const noexcept { return &ref; }
+        };
+
+        basic_iterator() = default;
+        basic_iterator(map_type* map, size_t index) noexcept : _map(map), _index(index) { skip(); }
+        operator basic_iterator<true>() const noexcept
+            requires(!Const)
+        {
+            return {_map, _index};
+        }
+
+        reference operator*() const noexcept { return {_map->_slots[_index].first, _map->_slots[_index].second}; }
+        pointer   operator->() const noexcept { return {**this}; }
+
+        basic_iterator& operator++() noexcept
+        {
+            ++_index;
+            skip();
+            return *this;
+        }
+        basic_iterator operator++(int) noexcept
+        {
+            auto it{*this};
+            ++*this;
+            return it;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept
+        {
+            return a._index == b._index;
+        }
+
+    private:
+        friend class any_flat_map;
+
+        void skip() noexcept
+        {
+            while (_index < _map->_capacity && _map->_ctrl[_index] < 0) ++_index;
+        }
+
+        map_type* _map{nullptr};
+        size_t    _index{0};
+    };
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    any_flat_map() = default;
+    // a copy that throws frees what it built: the elements are copied into a local map, swapped in when complete.
+    any_flat_map(const any_flat_map& rhs)
+    {
+        any_flat_map copy;
+        copy.reserve(rhs._size);
+        for (const auto& [k, v] : rhs) copy.emplace_new(hash_of(k), k, v);
+        swap(copy);
+    }
+    any_flat_map(any_flat_map&& rhs) noexcept { swap(rhs); }
+    any_flat_map& operator=(any_flat_map rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+    ~any_flat_map() { release(); }
+
+    void swap(any_flat_map& rhs) noexcept
+    {
+        std::swap(_ctrl, rhs._ctrl);
+        std::swap(_slots, rhs._slots);
+        std::swap(_capacity, rhs._capacity);
+        std::swap(_size, rhs._size);
+        std::swap(_deleted, rhs._deleted);
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return _size; }
+    [[nodiscard]] bool   empty() const noexcept { return _size == 0; }
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+    iterator       begin() noexcept { return {this, 0}; }
+    iterator       end() noexcept { return {this, _capacity}; }
+    const_iterator begin() const noexcept { return {this, 0}; }
+    const_iterator end() const noexcept { return {this, _capacity}; }
+
+    void clear() noexcept
+    {
+        destroy_slots();
+        if (_ctrl) std::memset(_ctrl, ctrl_empty, _capacity);
+        _size    = 0;
+        _deleted = 0;
+    }
+
+    // reserve - room for n elements without rehash.
+    void reserve(size_t n)
+    {
+        size_t capacity{group_width};
+        while (capacity * max_load_num / max_load_den < n) capacity *= 2;
+        if (capacity > _capacity) rehash(capacity);
+    }
+
+    template<typename K>
+    [[nodiscard]] iterator find(const K& key)
+    {
+        return {this, find_index(key)};
+    }
+    template<typename K>
+    [[nodiscard]] const_iterator find(const K& key) const
+    {
+        return {this, find_index(key)};
+    }
+    template<typename K>
+    [[nodiscard]] bool contains(const K& key) const
+    {
+        return find_index(key) != _capacity;
+    }
+
+    template<typename K>
+    [[nodiscard]] V& at(const K& key)
+    {
+        const size_t i{find_index(key)};
+        if (i == _capacity) throw std::out_of_range("any_flat_map::at");
+        return _slots[i].second;
+    }
+    template<typename K>
+    [[nodiscard]] const V& at(const K& key) const
+    {
+        const size_t i{find_index(key)};
+        if (i == _capacity) throw std::out_of_range("any_flat_map::at");
+        return _slots[i].second;
+    }
+
+    // try_emplace - inserts (key, V(args...)) when key is missing, key is an A or a plain key converted to A.
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        const uint64_t h{hash_of(key)};
+        const size_t   i{find_index(key, h)};
+        if (i != _capacity) return {iterator{this, i}, false};
+        return {iterator{this, emplace_new(h, std::forward<K>(key), std::forward<Args>(args)...)}, true};
+    }
+
+    template<typename K, typename M>
+    std::pair<iterator, bool> insert_or_assign(K&& key, M&& value)
+    {
+        auto result{try_emplace(std::forward<K>(key), std::forward<M>(value))};
+        if (!result.second) result.first->second = std::forward<M>(value);
+        return result;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    std::pair<iterator, bool> insert(value_type&& kv) { return try_emplace(std::move(kv.first), std::move(kv.second)); }
+
+    template<typename K>
+    V& operator[](K&& key)
+    {
+        return try_emplace(std::forward<K>(key)).first->second;
+    }
+
+    template<typename K>
+    size_t erase(const K& key)
+    {
+        const size_t i{find_index(key)};
+        if (i == _capacity) return 0;
+        erase_slot(i);
+        return 1;
+    }
+    iterator erase(iterator it)
+    {
+        const size_t i{it._index};
+        erase_slot(i);
+        return {this, i + 1};
+    }
+
+private:
+    // hash_of - the empty any is a valid key, with hash 0.
+    template<typename K>
+    static uint64_t hash_of(const K& key)
+    {
+        if constexpr (std::is_same_v<K, A>)
+        {
+            if (!key.has_value()) return 0;
+        }
+        return hash_mix(static_cast<uint64_t>(any_hash<A>{}(key)));
+    }
+    static size_t h1(uint64_t h) noexcept { return static_cast<size_t>(h >> 7); }
+    static int8_t h2(uint64_t h) noexcept { return static_cast<int8_t>(h & 0x7f); }
+
+    // key_equal - a stored key against a lookup key: the properties first, then one af_strict_eq call.
+    template<typename K>
+    static bool key_equal(const A& stored, const K& key)
+    {
+        if constexpr (std::is_same_v<K, A>)
+        {
+            return stored.properties() == key.properties() && (!key.has_value() || stored == key);
+        }
+        else
+        {
+            return any_equal_to<A>{}(stored, key);
+        }
+    }
+
+    template<typename K>
+    size_t find_index(const K& key) const
+    {
+        return find_index(key, hash_of(key));
+    }
+
+    template<typename K>
+    size_t find_index(const K& key, uint64_t h) const
+    {
+        if (_capacity == 0) return 0;
+        const size_t mask{_capacity / group_width - 1};
+        size_t       g{h1(h) & mask};
+        for (size_t step{1};; ++step)
+        {
+            const group grp{_ctrl + g * group_width};
+            for (uint32_t m{grp.match(h2(h))}; m; m &= m - 1)
+            {
+                const size_t i{g * group_width + static_cast<size_t>(std::countr_zero(m))};
+                if (key_equal(_slots[i].first, key)) [[likely]]
+                    return i;
+            }
+            if (grp.match_empty()) return _capacity;
+            g = (g + step) & mask;  // triangular probing visits every group.
+        }
+    }
+
+    // free_index - the first empty or deleted slot of the probe sequence of h.
+    size_t free_index(uint64_t h) const noexcept
+    {
+        const size_t mask{_capacity / group_width - 1};
+        size_t       g{h1(h) & mask};
+        for (size_t step{1};; ++step)
+        {
+            const group grp{_ctrl + g * group_width};
+            if (const uint32_t m{grp.match_free()})
+            {
+                return g * group_width + static_cast<size_t>(std::countr_zero(m));
+            }
+            g = (g + step) & mask;
+        }
+    }
+
+    template<typename K, typename... Args>
+    size_t emplace_new(uint64_t h, K&& key, Args&&... args)
+    {
+        if ((_size + _deleted + 1) * max_load_den > _capacity * max_load_num)
+        {
+            rehash(_size + 1 > _capacity * max_load_num / max_load_den / 2 ? std::max(_capacity * 2, group_width)
+                                                                              : _capacity);
+        }
+        const size_t i{free_index(h)};
+        if constexpr (std::is_same_v<std::remove_cvref_t<K>, A>)
+        {
+            std::construct_at(&_slots[i], std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        else
+        {
+            std::construct_at(&_slots[i], std::piecewise_construct,
+                              std::forward_as_tuple(any_key_t<std::remove_cvref_t<K>>(std::forward<K>(key))),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        if (_ctrl[i] == ctrl_deleted) --_deleted;
+        _ctrl[i] = h2(h);
+        ++_size;
+        return i;
+    }
+
+    void erase_slot(size_t i) noexcept
+    {
+        std::destroy_at(&_slots[i]);
+        // a slot in a group with an empty slot ends every probe sequence through it, it can be empty again.
+        const group grp{_ctrl + i / group_width * group_width};
+        if (grp.match_empty())
+        {
+            _ctrl[i] = ctrl_empty;
+        }
+        else
+        {
+            _ctrl[i] = ctrl_deleted;
+            ++_deleted;
+        }
+        --_size;
+    }
+
+    void rehash(size_t capacity)
+    {
+        any_flat_map next;
+        next._ctrl     = static_cast<int8_t*>(::operator new(capacity, std::align_val_t{group_width}));
+        next._slots    = std::allocator<value_type>{}.allocate(capacity);
+        next._capacity = capacity;
+        std::memset(next._ctrl, ctrl_empty, capacity);
+        for (size_t i{0}; i < _capacity; ++i)
+        {
+            if (_ctrl[i] >= 0)
+            {
+                const uint64_t h{hash_of(_slots[i].first)};
+                const size_t   j{next.free_index(h)};
+                relocate(&next._slots[j], _slots[i]);
+                next._ctrl[j] = h2(h);
+                ++next._size;
+            }
+        }
+        swap(next);
+    }
+
+    // relocate - moves the element, copies it when the move of the value may throw: this table then stays whole
+    //  until the new one is complete.
+    static void relocate(value_type* to, value_type& from)
+    {
+        if constexpr (std::is_nothrow_move_constructible_v<V>)
+        {
+            std::construct_at(to, std::move(from));
+        }
+        else
+        {
+            std::construct_at(to, std::as_const(from));
+        }
+    }
+
+    void destroy_slots() noexcept
+    {
+        for (size_t i{0}; i < _capacity; ++i)
+        {
+            if (_ctrl[i] >= 0) std::destroy_at(&_slots[i]);
+        }
+    }
+
+    void release() noexcept
+    {
+        if (!_ctrl) return;
+        destroy_slots();
+        ::operator delete(_ctrl, std::align_val_t{group_width});
+        std::allocator<value_type>{}.deallocate(_slots, _capacity);
+        _ctrl     = nullptr;
+        _slots    = nullptr;
+        _capacity = 0;
+    }
+
+    int8_t*     _ctrl{nullptr};
+    value_type* _slots{nullptr};
+    size_t      _capacity{0};  // a power of 2, a multiple of group_width, or 0.
+    size_t      _size{0};
+    size_t      _deleted{0};
+};
+
+}  // namespace ext
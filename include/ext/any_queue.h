@@ -0,0 +1,294 @@
+#pragma once
+
+// clang-format off
+// any_queue - bounded lock-free queues of ext::any values between threads.
+// The values are constructed in place in the slots of a ring allocated once: try_emplace<T>(args...) builds the T in
+// its slot, try_pop(out) moves it out with the _move of its properties (a memcpy for the trivial ones) and empties
+// the slot, so the in place types never allocate. The positions of the two sides are in their own cache lines.
+//
+// any_spsc_queue<A> - one producer thread and one consumer thread, each side caches the position of the other and
+//  reads its cache line only when the queue looks full or empty.
+// any_mpmc_queue<A> - any number of producers and consumers, a sequence number per slot (D. Vyukov's bounded MPMC
+//  queue). A slot is a multiple of 64 bytes, any<48> and its sequence fill one cache line.
+//
+//      ext::any_spsc_queue<ext::any<48>> q{1024};
+//      q.try_emplace<order>(id, price);            // producer
+//      ext::any<48> m; if (q.try_pop(m)) ...        // consumer
+// clang-format on
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "any.h"
+
+namespace ext {
+
+template<typename A>
+class any_spsc_queue
+{
+public:
+    // capacity - rounded up to a power of 2.
+    explicit any_spsc_queue(size_t capacity)
+        : _mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1}, _slots{std::make_unique<A[]>(_mask + 1)}
+    {
+    }
+
+    any_spsc_queue(const any_spsc_queue&)            = delete;
+    any_spsc_queue& operator=(const any_spsc_queue&) = delete;
+
+    [[nodiscard]] size_t capacity() const noexcept { return _mask + 1; }
+
+    // try_emplace<T> - constructs a T in the next slot, false when the queue is full. When the constructor throws,
+    //  nothing is queued.
+    template<typename T, typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        A* slot{producer_slot()};
+        if (!slot)
+        {
+            return false;
+        }
+        slot->template emplace<T>(std::forward<Args>(args)...);
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(A&& a)
+    {
+        A* slot{producer_slot()};
+        if (!slot)
+        {
+            return false;
+        }
+        // the slot is empty: move construct, no assignment of a value to a value.
+        std::destroy_at(slot);
+        std::construct_at(slot, std::move(a));
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    // emplace<T> / push - wait while the queue is full.
+    template<typename T, typename... Args>
+    void emplace(Args&&... args)
+    {
+        // try_emplace does not use the arguments when it returns false.
+        while (!try_emplace<T>(std::forward<Args>(args)...)) std::this_thread::yield();
+    }
+
+    void push(A&& a)
+    {
+        while (!try_push(std::move(a))) std::this_thread::yield();
+    }
+
+    // try_consume - calls f(A&) with the value at the front, in its slot, then empties the slot. False when the
+    //  queue is empty. When f throws, the value stays at the front.
+    template<typename F>
+    bool try_consume(F&& f)
+    {
+        const size_t tail{_tail.load(std::memory_order_relaxed)};
+        if (tail == _head_cache)
+        {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail == _head_cache)
+            {
+                return false;
+            }
+        }
+        A& slot{_slots[tail & _mask]};
+        std::forward<F>(f)(slot);
+        slot.reset();
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // try_pop - moves the value at the front to out, false when the queue is empty.
+    bool try_pop(A& out)
+    {
+        return try_consume([&](A& slot) { out = std::move(slot); });
+    }
+
+    void pop(A& out)
+    {
+        while (!try_pop(out)) std::this_thread::yield();
+    }
+
+private:
+    // producer_slot - the slot at the head, nullptr when the queue is full.
+    A* producer_slot() noexcept
+    {
+        const size_t head{_head.load(std::memory_order_relaxed)};
+        if (head - _tail_cache == capacity())
+        {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head - _tail_cache == capacity())
+            {
+                return nullptr;
+            }
+        }
+        return &_slots[head & _mask];
+    }
+
+    const size_t         _mask;
+    std::unique_ptr<A[]> _slots;
+
+    alignas(64) std::atomic<size_t> _head{0};  // producer: the next slot to fill
+    size_t _tail_cache{0};                     // producer: _tail last read
+    alignas(64) std::atomic<size_t> _tail{0};  // consumer: the next slot to empty
+    size_t _head_cache{0};                     // consumer: _head last read
+};
+
+template<typename A>
+class any_mpmc_queue
+{
+public:
+    // capacity - rounded up to a power of 2.
+    explicit any_mpmc_queue(size_t capacity)
+        : _mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1}, _slots{std::make_unique<slot[]>(_mask + 1)}
+    {
+        for (size_t i{0}; i <= _mask; ++i)
+        {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    any_mpmc_queue(const any_mpmc_queue&)            = delete;
+    any_mpmc_queue& operator=(const any_mpmc_queue&) = delete;
+
+    [[nodiscard]] size_t capacity() const noexcept { return _mask + 1; }
+
+    // try_emplace<T> - constructs a T in the next slot, false when the queue is full. When the constructor throws,
+    //  the slot is already claimed: an empty any is queued and the exception is rethrown.
+    template<typename T, typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        size_t pos;
+        slot*  s{claim_push(pos)};
+        if (!s)
+        {
+            return false;
+        }
+        try
+        {
+            s->value.template emplace<T>(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            s->sequence.store(pos + 1, std::memory_order_release);
+            throw;
+        }
+        s->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(A&& a)
+    {
+        size_t pos;
+        slot*  s{claim_push(pos)};
+        if (!s)
+        {
+            return false;
+        }
+        std::destroy_at(&s->value);  // empty, see try_pop
+        std::construct_at(&s->value, std::move(a));
+        s->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T, typename... Args>
+    void emplace(Args&&... args)
+    {
+        // try_emplace does not use the arguments when it returns false.
+        while (!try_emplace<T>(std::forward<Args>(args)...)) std::this_thread::yield();
+    }
+
+    void push(A&& a)
+    {
+        while (!try_push(std::move(a))) std::this_thread::yield();
+    }
+
+    // try_pop - moves the value at the front to out, false when the queue is empty.
+    bool try_pop(A& out)
+    {
+        size_t pos{_tail.load(std::memory_order_relaxed)};
+        slot*  s;
+        for (;;)
+        {
+            s = &_slots[pos & _mask];
+            const size_t   sequence{s->sequence.load(std::memory_order_acquire)};
+            const intptr_t diff{static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1)};
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;  // the slot is not filled yet: empty
+            }
+            else
+            {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(s->value);
+        s->value.reset();
+        s->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    void pop(A& out)
+    {
+        while (!try_pop(out)) std::this_thread::yield();
+    }
+
+private:
+    // slot - the sequence is the position the slot is ready for: pos to be filled, pos + 1 to be emptied.
+    struct alignas(64) slot
+    {
+        std::atomic<size_t> sequence{0};
+        A                   value;
+    };
+
+    // claim_push - the slot of the next position, claimed by this producer, nullptr when the queue is full.
+    slot* claim_push(size_t& pos) noexcept
+    {
+        pos = _head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot*          s{&_slots[pos & _mask]};
+            const size_t   sequence{s->sequence.load(std::memory_order_acquire)};
+            const intptr_t diff{static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos)};
+            if (diff == 0)
+            {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    return s;
+                }
+            }
+            else if (diff < 0)
+            {
+                return nullptr;  // the slot is not emptied yet: full
+            }
+            else
+            {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const size_t            _mask;
+    std::unique_ptr<slot[]> _slots;
+
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+};
+
+}  // namespace ext
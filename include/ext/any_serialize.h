@@ -0,0 +1,467 @@
+#pragma once
+
+// clang-format off
+// af_serialize - binary records of ext::any values, written to a caller buffer and read back through a registry of
+// the value types, for recording and replaying streams of heterogeneous values without text parsing.
+//
+// A record is a 16 bytes header, the type id and the payload size, then the payload padded to 8 bytes, so the
+// records of a buffer stay 8 bytes aligned:
+//      uint64_t type_id   - type_fingerprint<T>(), the FNV-1a of the type name: the same in every run and shared
+//                           object built with the same compiler. 0 for the empty any.
+//      uint32_t size      - the payload size, in bytes.
+//      uint32_t reserved  - 0.
+// The payload is written by ext::serializer<T>: the bytes of the value for the arithmetic and enum types and the
+// types opted in with ext::is_bitwise_serializable<T>, a checked 0 or 1 byte for bool, the characters for
+// std::string. Specialize serializer<T> for other types. The integers are in the native byte order.
+// clang-format on
+
+#include <algorithm>
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "any.h"
+
+namespace ext {
+
+// any_record_header - the header of a record, followed by size bytes of payload and the padding to record_alignment.
+struct any_record_header
+{
+    uint64_t type_id{0};
+    uint32_t size{0};
+    uint32_t reserved{0};
+};
+static_assert(sizeof(any_record_header) == 16);
+
+constexpr size_t record_alignment{8};
+
+constexpr size_t record_size(size_t payload_size) noexcept
+{
+    return sizeof(any_record_header) + (payload_size + record_alignment - 1) / record_alignment * record_alignment;
+}
+
+// is_bitwise_serializable<T> - the payload of a T may be the bytes of the value: true for the arithmetic types but
+//  bool, whose byte must be checked, and the enum types. Trivially copyable is not enough, the bytes of a pointer,
+//  a std::string_view or a std::span mean nothing in another process or run: specialize it as std::true_type for a
+//  trivially copyable type without such members.
+//      template<> struct ext::is_bitwise_serializable<quote> : std::true_type {};
+template<typename T>
+struct is_bitwise_serializable
+    : std::bool_constant<(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T>>
+{
+};
+
+template<typename T>
+constexpr bool is_bitwise_serializable_v{is_bitwise_serializable<T>::value};
+
+// serializer<T> - the payload of a T:
+//      static size_t size(const T&)                        - the payload size.
+//      static void   write(std::byte* out, const T&)       - writes size() bytes.
+//      static T      read(std::span<const std::byte> in)   - the T of a payload, throws std::runtime_error if invalid.
+//      static constexpr bool bytewise                      - optional, true when the payload is the bytes of the T.
+template<typename T>
+struct serializer;
+
+template<typename T>
+    requires(is_bitwise_serializable_v<T>)
+struct serializer<T>
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ext::is_bitwise_serializable<T> requires a trivially copyable T");
+
+    static constexpr bool bytewise{true};
+
+    static constexpr size_t size(const T&) noexcept { return sizeof(T); }
+
+    static void write(std::byte* out, const T& value) noexcept { std::memcpy(out, &value, sizeof(T)); }
+
+    static T read(std::span<const std::byte> in)
+    {
+        if (in.size() != sizeof(T))
+        {
+            throw std::runtime_error("ext::serializer: payload size does not match the type");
+        }
+        // a trivially copyable T is an implicit lifetime type, the memcpy creates it.
+        alignas(T) std::byte storage[sizeof(T)];
+        std::memcpy(storage, in.data(), sizeof(T));
+        return *std::launder(reinterpret_cast<T*>(storage));
+    }
+};
+
+// serializer<bool> - one byte, 0 or 1: any other byte is not a bool, read throws.
+template<>
+struct serializer<bool>
+{
+    static constexpr size_t size(bool) noexcept { return 1; }
+
+    static void write(std::byte* out, bool value) noexcept { *out = std::byte{value}; }
+
+    static bool read(std::span<const std::byte> in)
+    {
+        if (in.size() != 1 || std::to_integer<uint8_t>(in[0]) > 1)
+        {
+            throw std::runtime_error("ext::serializer<bool>: payload is not a bool");
+        }
+        return in[0] == std::byte{1};
+    }
+};
+
+template<>
+struct serializer<std::string>
+{
+    static size_t size(const std::string& value) noexcept { return value.size(); }
+
+    static void write(std::byte* out, const std::string& value) noexcept
+    {
+        std::memcpy(out, value.data(), value.size());
+    }
+
+    static std::string read(std::span<const std::byte> in)
+    {
+        return std::string(reinterpret_cast<const char*>(in.data()), in.size());
+    }
+};
+
+template<typename T>
+constexpr bool is_serializable_v = requires(const T& value, std::byte* out, std::span<const std::byte> in) {
+    { serializer<T>::size(value) } -> std::convertible_to<size_t>;
+    serializer<T>::write(out, value);
+    { serializer<T>::read(in) } -> std::same_as<T>;
+};
+
+// is_bytewise_serialized_v - the payload of a T is the bytes of the value, it can be used in place (any_archive).
+template<typename T>
+constexpr bool is_bytewise_serialized_v = requires {
+    requires serializer<T>::bytewise;
+};
+
+template<typename T>
+struct af_serialize;
+
+// af_serialize - a.serialized_size() and a.serialize(out), the record of the value, see any_registry to read it back.
+template<size_t N, template<typename> class... Features>
+struct af_serialize<any<N, Features...>>
+{
+    using A = any<N, Features...>;
+
+    struct extend_properties
+    {
+    };
+    struct extend_cold_properties
+    {
+        size_t (*_payload_size)(const A&){nullptr};
+        void (*_write_payload)(std::byte*, const A&){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto&)
+    {
+    }
+
+    template<typename T>
+    static constexpr void construct_extend_cold_properties(auto& prop)
+    {
+        static_assert(is_serializable_v<T>,
+                      "af_serialize requires a type with an ext::serializer<T> or ext::is_bitwise_serializable<T>");
+
+        prop._payload_size  = &payload_size<T>;
+        prop._write_payload = &write_payload<T>;
+    }
+
+    template<typename T>
+    static size_t payload_size(const A& a)
+    {
+        return serializer<T>::size(a.template data<T>());
+    }
+
+    template<typename T>
+    static void write_payload(std::byte* out, const A& a)
+    {
+        serializer<T>::write(out, a.template data<T>());
+    }
+
+    // serialized_size - the size of the record, header and padding included.
+    [[nodiscard]] size_t serialized_size() const
+    {
+        auto self = static_cast<const A*>(this);
+        return record_size(self->has_value() ? self->cold_properties()->_payload_size(*self) : 0);
+    }
+
+    // serialize - writes the record at the front of out, returns its size, or 0 when out is too small.
+    size_t serialize(std::span<std::byte> out) const
+    {
+        auto                self = static_cast<const A*>(this);
+        const auto*         cold{self->cold_properties()};
+        const size_t        payload{cold ? cold->_payload_size(*self) : 0};
+        const size_t        size{record_size(payload)};
+        if (out.size() < size)
+        {
+            return 0;
+        }
+        if (payload > UINT32_MAX)
+        {
+            throw std::length_error("ext::any record payload larger than 4 GiB");
+        }
+        const any_record_header header{self->fingerprint(), static_cast<uint32_t>(payload), 0};
+        std::memcpy(out.data(), &header, sizeof(header));
+        if (cold)
+        {
+            // zero the last word first, the payload overwrites all of it but the padding.
+            std::memset(out.data() + size - record_alignment, 0, record_alignment);
+            cold->_write_payload(out.data() + sizeof(header), *self);
+        }
+        return size;
+    }
+};
+
+// serialized_size(values) - the size of the records of a range of anys.
+template<std::ranges::input_range R>
+size_t serialized_size(const R& values)
+{
+    size_t size{0};
+    for (const auto& a : values) size += a.serialized_size();
+    return size;
+}
+
+// serialize_all(values, out) - appends the records of a range of anys to out, one resize for the range.
+template<std::ranges::input_range R>
+void serialize_all(const R& values, std::vector<std::byte>& out)
+{
+    size_t at{out.size()};
+    out.resize(at + serialized_size(values));
+    for (const auto& a : values)
+    {
+        at += a.serialize(std::span<std::byte>{out}.subspan(at));
+    }
+}
+
+// any_registry<A> - the value types records can be read back to, by type id.
+//      ext::any_registry<A> registry;
+//      registry.add<int, double, std::string>();
+//      std::vector<A> values;
+//      registry.read_all(buffer, values);
+template<typename A>
+class any_registry
+{
+public:
+    template<typename... Ts>
+    void add()
+    {
+        (add_type<Ts>(), ...);
+    }
+
+    template<typename T>
+    [[nodiscard]] bool contains() const noexcept
+    {
+        const entry* e{find(type_fingerprint<T>())};
+        return e && e->read == &read_value<T>;
+    }
+
+    // properties - the properties of the anys holding the type of type_id, nullptr when it is not in the registry.
+    [[nodiscard]] const typename A::any_properties* properties(uint64_t type_id) const noexcept
+    {
+        const entry* e{find(type_id)};
+        return e ? e->properties : nullptr;
+    }
+
+    // read - the any of the record at the front of in, in advances past the record.
+    A read(std::span<const std::byte>& in) const
+    {
+        A out{};
+        read_record(in, out, nullptr);
+        return out;
+    }
+
+    // read_all - appends the anys of all the records of in to out, returns their number. When a record cannot be
+    //  read, the anys of the records before it stay in out, nothing else is added.
+    size_t read_all(std::span<const std::byte> in, std::vector<A>& out) const
+    {
+        const size_t first{out.size()};
+        const entry* last{nullptr};
+        while (!in.empty())
+        {
+            A a{};
+            last = read_record(in, a, last);
+            out.push_back(std::move(a));
+        }
+        return out.size() - first;
+    }
+
+private:
+    struct entry
+    {
+        uint64_t type_id;
+        void (*read)(A&, std::span<const std::byte>);
+        const typename A::any_properties* properties;
+    };
+
+    template<typename T>
+    static void read_value(A& out, std::span<const std::byte> payload)
+    {
+        out.template emplace<T>(serializer<T>::read(payload));
+    }
+
+    template<typename T>
+    void add_type()
+    {
+        static_assert(is_serializable_v<T>,
+                      "any_registry requires a type with an ext::serializer<T> or ext::is_bitwise_serializable<T>");
+        const uint64_t id{type_fingerprint<T>()};
+        auto           it{std::ranges::lower_bound(_entries, id, {}, &entry::type_id)};
+        if (it != _entries.end() && it->type_id == id)
+        {
+            if (it->read != &read_value<T>)
+            {
+                throw std::logic_error("ext::any_registry: two types with the same type id");
+            }
+            return;
+        }
+        _entries.insert(it, entry{id, &read_value<T>, A::template properties_of<T>()});
+    }
+
+    const entry* find(uint64_t id) const noexcept
+    {
+        const auto it{std::ranges::lower_bound(_entries, id, {}, &entry::type_id)};
+        return it != _entries.end() && it->type_id == id ? &*it : nullptr;
+    }
+
+    // read_record - reads the record at the front of in into out, hint is the entry of the previous record, a
+    //  replay has runs of the same type. Returns the entry of this record.
+    const entry* read_record(std::span<const std::byte>& in, A& out, const entry* hint) const
+    {
+        any_record_header header;
+        if (in.size() < sizeof(header))
+        {
+            throw std::runtime_error("ext::any record truncated");
+        }
+        std::memcpy(&header, in.data(), sizeof(header));
+        const size_t size{record_size(header.size)};
+        if (in.size() < size)
+        {
+            throw std::runtime_error("ext::any record truncated");
+        }
+        const std::span<const std::byte> payload{in.subspan(sizeof(header), header.size)};
+        in = in.subspan(size);
+        if (header.type_id == 0)
+        {
+            out.reset();
+            return hint;
+        }
+        const entry* e{hint && hint->type_id == header.type_id ? hint : find(header.type_id)};
+        if (!e)
+        {
+            throw std::runtime_error("ext::any record of a type not in the registry");
+        }
+        e->read(out, payload);
+        return e;
+    }
+
+    std::vector<entry> _entries;  // sorted by type_id
+};
+
+// any_record_ref - a record read in place, in an archive or a ring, valid as long as its bytes are.
+template<typename A>
+class any_record_ref
+{
+public:
+    // record - the record, already checked to be readable, properties - of its type in A or nullptr, registry - to
+    //  load() it.
+    any_record_ref(const std::byte* record, uint32_t size, const typename A::any_properties* properties,
+                   const any_registry<A>* registry) noexcept
+        : _record{record}, _size{size}, _properties{properties}, _registry{registry}
+    {
+    }
+
+    [[nodiscard]] uint64_t type_id() const noexcept
+    {
+        uint64_t id;
+        std::memcpy(&id, _record, sizeof(id));
+        return id;
+    }
+    [[nodiscard]] bool has_value() const noexcept { return type_id() != 0; }
+
+    // properties - the properties of the anys of the record type, nullptr when empty or not in the registry.
+    [[nodiscard]] const typename A::any_properties* properties() const noexcept { return _properties; }
+    [[nodiscard]] std::string_view src_type_name() const noexcept
+    {
+        return _properties ? _properties->_cold->_src_type_name : std::string_view{};
+    }
+
+    template<typename T>
+    [[nodiscard]] bool holds() const noexcept
+    {
+        return _properties == A::template properties_of<T>();
+    }
+
+    [[nodiscard]] std::span<const std::byte> payload() const noexcept
+    {
+        return {_record + sizeof(any_record_header), _size};
+    }
+
+    // get_if<T> - the T in the record bytes, nullptr when the record is not a T, or when its payload cannot be one:
+    //  not sizeof(T) bytes (a corrupted record) or not aligned for T (bytes not 8 bytes aligned), load() it instead.
+    template<typename T>
+    [[nodiscard]] const T* get_if() const noexcept
+    {
+        return holds<T>() ? payload_as<T>() : nullptr;
+    }
+
+    // get<T> - the T in the record bytes, throws std::bad_any_cast when the record is not a T, std::runtime_error
+    //  when its payload cannot be one, see get_if<T>().
+    template<typename T>
+    [[nodiscard]] const T& get() const
+    {
+        if (!holds<T>())
+        {
+            throw std::bad_any_cast{};
+        }
+        const T* p{payload_as<T>()};
+        if (!p)
+        {
+            throw std::runtime_error("ext::any_record_ref: the payload size or alignment does not match the type");
+        }
+        return *p;
+    }
+
+    // load - the any of the record, read by the serializer of its type, throws as any_registry<A>::read.
+    [[nodiscard]] A load() const
+    {
+        std::span<const std::byte> in{_record, record_size(_size)};
+        return _registry->read(in);
+    }
+
+private:
+    template<typename T>
+    [[nodiscard]] const T* payload_as() const noexcept
+    {
+        static_assert(is_bytewise_serialized_v<T> && alignof(T) <= record_alignment,
+                      "any_record_ref::get<T> requires a bytewise serialized T, use load()");
+        const std::byte* p{_record + sizeof(any_record_header)};
+        if (_size != sizeof(T) || reinterpret_cast<uintptr_t>(p) % alignof(T) != 0)
+        {
+            return nullptr;
+        }
+#if defined(__cpp_lib_start_lifetime_as)
+        return std::start_lifetime_as<T>(p);
+#else
+        // the bytes of a T written by its bytewise serializer, an implicit lifetime type.
+        return std::launder(reinterpret_cast<const T*>(p));
+#endif
+    }
+
+    const std::byte*                  _record;
+    uint32_t                          _size;
+    const typename A::any_properties* _properties;
+    const any_registry<A>*            _registry;
+};
+
+}  // namespace ext
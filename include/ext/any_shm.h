@@ -0,0 +1,373 @@
+#pragma once
+
+// clang-format off
+// any_shm - ext::any values passed between processes through shared memory.
+// The properties pointer of an any is local to its process, so an any itself cannot be shared. In shared memory a
+// value is its af_serialize record: the type fingerprint, then the payload, the bytes of a bitwise serializable value
+// or the serializer output of the others (the characters of a std::string), at an offset in the segment. The reader
+// rehydrates it with its own any_registry: get<T>() reads a bitwise serializable value in place, load() builds the
+// any.
+//
+// any_shm_ring<A> - a single producer single consumer ring of records in a shm_segment:
+//      ext::shm_segment segment{ext::shm_segment::create("/feed", ext::any_shm_ring<A>::segment_size(1 << 20))};
+//      auto producer{ext::any_shm_ring<A>::create(segment.bytes(), registry)};
+//      producer.try_push(a);
+//  in the other process:
+//      ext::shm_segment segment{ext::shm_segment::open("/feed")};
+//      auto consumer{ext::any_shm_ring<A>::attach(segment.bytes(), registry)};
+//      consumer.try_consume([](const ext::any_record_ref<A>& r) { if (auto* q = r.get_if<quote>()) ...; });
+// Each side keeps its own any_shm_ring object, with a cache of the other side's position: a push or a pop reads the
+// other side's cache line only when the ring looks full or empty.
+// clang-format on
+
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "any_serialize.h"
+
+namespace ext {
+
+constexpr char     shm_ring_magic[8]{'e', 'x', 't', 'r', 'i', 'n', 'g', '\1'};
+constexpr uint32_t shm_ring_version{1};
+
+// A type id which is not a record: the records continue at the start of the ring.
+constexpr uint64_t shm_ring_wrap_marker{~uint64_t{0}};
+
+// shm_ring_control - the first bytes of the ring memory, the positions are the bytes written and read since the
+//  creation, each in its own cache line.
+struct shm_ring_control
+{
+    char     magic[8]{};
+    uint32_t version{0};
+    uint32_t reserved{0};
+    uint64_t capacity{0};
+
+    alignas(64) std::atomic<uint64_t> head{0};  // written by the producer
+    alignas(64) std::atomic<uint64_t> tail{0};  // written by the consumer
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring positions must be lock free to be shared");
+
+template<typename A>
+class any_shm_ring
+{
+public:
+    // segment_size - the memory size for a ring of capacity bytes of records, capacity a power of 2.
+    static constexpr size_t segment_size(size_t capacity) noexcept { return sizeof(shm_ring_control) + capacity; }
+
+    // create - a new ring in memory (64 bytes aligned), its capacity the largest power of 2 that fits.
+    static any_shm_ring create(std::span<std::byte> memory, const any_registry<A>& registry)
+    {
+        check_memory(memory);
+        if (memory.size() < segment_size(64))
+        {
+            throw std::invalid_argument("ext::any_shm_ring: memory too small");
+        }
+        const size_t capacity{std::bit_floor(memory.size() - sizeof(shm_ring_control))};
+        auto* control{std::construct_at(reinterpret_cast<shm_ring_control*>(memory.data()))};
+        control->capacity = capacity;
+        control->version  = shm_ring_version;
+        std::memcpy(control->magic, shm_ring_magic, sizeof(shm_ring_magic));
+        return any_shm_ring{control, memory.data() + sizeof(shm_ring_control), registry};
+    }
+
+    // attach - the ring created in memory, by another process or another side of this one.
+    static any_shm_ring attach(std::span<std::byte> memory, const any_registry<A>& registry)
+    {
+        check_memory(memory);
+        if (memory.size() < sizeof(shm_ring_control))
+        {
+            throw std::runtime_error("ext::any_shm_ring: no ring in this memory");
+        }
+        auto* control{std::launder(reinterpret_cast<shm_ring_control*>(memory.data()))};
+        if (std::memcmp(control->magic, shm_ring_magic, sizeof(shm_ring_magic)) ||
+            control->version != shm_ring_version || !std::has_single_bit(control->capacity) ||
+            control->capacity > memory.size() - sizeof(shm_ring_control))
+        {
+            throw std::runtime_error("ext::any_shm_ring: no ring in this memory");
+        }
+        return any_shm_ring{control, memory.data() + sizeof(shm_ring_control), registry};
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept { return _mask + 1; }
+
+    // try_push - writes the record of a at the head of the ring, false when the ring is full. Throws
+    //  std::length_error when the record is larger than half the ring, it could never fit.
+    bool try_push(const A& a)
+    {
+        const size_t size{a.serialized_size()};
+        if (size > capacity() / 2)
+        {
+            throw std::length_error("ext::any_shm_ring: record larger than half the ring");
+        }
+        const uint64_t head{_control->head.load(std::memory_order_relaxed)};
+        const size_t   pos{head & _mask};
+        const size_t   contiguous{capacity() - pos};
+        const size_t   need{contiguous < size ? contiguous + size : size};  // a record is never split
+        if (head + need - _tail_cache > capacity())
+        {
+            _tail_cache = _control->tail.load(std::memory_order_acquire);
+            if (head + need - _tail_cache > capacity())
+            {
+                return false;
+            }
+        }
+        size_t at{pos};
+        if (contiguous < size)
+        {
+            std::memcpy(_data + pos, &shm_ring_wrap_marker, sizeof(shm_ring_wrap_marker));
+            at = 0;
+        }
+        a.serialize(std::span<std::byte>{_data + at, size});
+        _control->head.store(head + need, std::memory_order_release);
+        return true;
+    }
+
+    // try_consume - calls f(const any_record_ref<A>&) with the record at the tail of the ring, in place, then
+    //  releases it. False when the ring is empty. When f throws, the record is not released: call skip() to drop it.
+    template<typename F>
+    bool try_consume(F&& f)
+    {
+        uint64_t tail{_control->tail.load(std::memory_order_relaxed)};
+        if (tail == _head_cache)
+        {
+            _head_cache = _control->head.load(std::memory_order_acquire);
+            if (tail == _head_cache)
+            {
+                return false;
+            }
+        }
+        size_t   pos{tail & _mask};
+        uint64_t type_id;
+        std::memcpy(&type_id, _data + pos, sizeof(type_id));
+        if (type_id == shm_ring_wrap_marker)
+        {
+            tail += capacity() - pos;
+            pos = 0;
+        }
+        any_record_header header;
+        std::memcpy(&header, _data + pos, sizeof(header));
+        const size_t size{record_size(header.size)};
+        if (size > capacity() - pos || tail + size > _head_cache)
+        {
+            throw std::runtime_error("ext::any_shm_ring: invalid record");
+        }
+        if (header.type_id != _last_type)
+        {
+            _last_properties = _registry->properties(header.type_id);
+            _last_type       = header.type_id;
+        }
+        std::forward<F>(f)(any_record_ref<A>{_data + pos, header.size, _last_properties, _registry});
+        _control->tail.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+    // try_pop - the any of the record at the tail of the ring, false when the ring is empty. A record which cannot
+    //  be loaded (its type not in the registry, an invalid payload) is released before the exception of load() is
+    //  rethrown: the next try_pop reads the next record.
+    bool try_pop(A& out)
+    {
+        std::exception_ptr error;
+        const bool         popped{try_consume([&](const any_record_ref<A>& r) {
+            try
+            {
+                out = r.load();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        })};
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return popped;
+    }
+
+    // skip - releases the record at the tail of the ring without reading it, false when the ring is empty.
+    bool skip()
+    {
+        return try_consume([](const any_record_ref<A>&) {});
+    }
+
+private:
+    any_shm_ring(shm_ring_control* control, std::byte* data, const any_registry<A>& registry) noexcept
+        : _control{control},
+          _data{data},
+          _mask{control->capacity - 1},
+          _registry{&registry},
+          _tail_cache{control->tail.load(std::memory_order_acquire)},
+          _head_cache{control->head.load(std::memory_order_acquire)}
+    {
+    }
+
+    static void check_memory(std::span<std::byte> memory)
+    {
+        if (reinterpret_cast<uintptr_t>(memory.data()) % alignof(shm_ring_control))
+        {
+            throw std::invalid_argument("ext::any_shm_ring: memory not 64 bytes aligned");
+        }
+    }
+
+    shm_ring_control*                 _control;
+    std::byte*                        _data;
+    size_t                            _mask;
+    const any_registry<A>*            _registry;
+    uint64_t                          _tail_cache;  // producer: the consumer position last read
+    uint64_t                          _head_cache;  // consumer: the producer position last read
+    uint64_t                          _last_type{0};  // consumer: the type of the last record, and its properties
+    const typename A::any_properties* _last_properties{nullptr};
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// shm_segment - a shared memory segment mapped read write. Throws std::system_error when it cannot be created,
+//  opened or mapped.
+class shm_segment
+{
+public:
+    // create - a new named segment (shm_open) of size bytes. The name is removed when this object is destroyed, the
+    //  processes which opened the segment keep it.
+    static shm_segment create(const std::string& name, size_t size)
+    {
+        const int fd{::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)};
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "ext::shm_segment: shm_open " + name);
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            const int error{errno};
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "ext::shm_segment: ftruncate " + name);
+        }
+        return shm_segment{fd, name};
+    }
+
+    // open - a named segment created by another process.
+    static shm_segment open(const std::string& name)
+    {
+        const int fd{::shm_open(name.c_str(), O_RDWR, 0)};
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "ext::shm_segment: shm_open " + name);
+        }
+        return shm_segment{fd, {}};
+    }
+
+#if defined(__linux__)
+    // anonymous - a memfd segment of size bytes, shared with the children after fork(), or with another process by
+    //  passing fd() over a unix socket.
+    static shm_segment anonymous(size_t size)
+    {
+        const int fd{::memfd_create("ext::shm_segment", MFD_CLOEXEC)};
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "ext::shm_segment: memfd_create");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            const int error{errno};
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "ext::shm_segment: ftruncate");
+        }
+        return shm_segment{fd, {}};
+    }
+#endif
+
+    // adopt - the segment of a file descriptor received from another process, closed with this object.
+    static shm_segment adopt(int fd) { return shm_segment{fd, {}}; }
+
+    shm_segment(const shm_segment&)            = delete;
+    shm_segment& operator=(const shm_segment&) = delete;
+    shm_segment(shm_segment&& rhs) noexcept
+        : _fd{std::exchange(rhs._fd, -1)},
+          _data{std::exchange(rhs._data, nullptr)},
+          _size{std::exchange(rhs._size, 0)},
+          _unlink_name{std::move(rhs._unlink_name)}
+    {
+        rhs._unlink_name.clear();
+    }
+    shm_segment& operator=(shm_segment&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            release();
+            _fd          = std::exchange(rhs._fd, -1);
+            _data        = std::exchange(rhs._data, nullptr);
+            _size        = std::exchange(rhs._size, 0);
+            _unlink_name = std::move(rhs._unlink_name);
+            rhs._unlink_name.clear();
+        }
+        return *this;
+    }
+    ~shm_segment() { release(); }
+
+    [[nodiscard]] std::span<std::byte> bytes() const noexcept { return {static_cast<std::byte*>(_data), _size}; }
+    [[nodiscard]] int                  fd() const noexcept { return _fd; }
+
+private:
+    shm_segment(int fd, std::string unlink_name) : _fd{fd}, _unlink_name{std::move(unlink_name)}
+    {
+        struct stat st{};
+        void*       p{MAP_FAILED};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (p == MAP_FAILED)
+        {
+            const int error{st.st_size > 0 ? errno : EINVAL};
+            release();
+            throw std::system_error(error, std::generic_category(), "ext::shm_segment: mmap");
+        }
+        _data = p;
+        _size = static_cast<size_t>(st.st_size);
+    }
+
+    void release() noexcept
+    {
+        if (_data)
+        {
+            ::munmap(_data, _size);
+        }
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+        if (!_unlink_name.empty())
+        {
+            ::shm_unlink(_unlink_name.c_str());
+        }
+        _data = nullptr;
+        _fd   = -1;
+        _unlink_name.clear();
+    }
+
+    int         _fd{-1};
+    void*       _data{nullptr};
+    size_t      _size{0};
+    std::string _unlink_name;
+};
+#endif
+
+}  // namespace ext
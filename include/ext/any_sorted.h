@@ -0,0 +1,461 @@
+#pragma once
+
+// clang-format off
+// any_sorted_set<A> / any_sorted_map<A, V> - sorted sets and maps of ext::any keys in contiguous vectors, for read
+// mostly tables: a lookup is a binary search over one array of keys, instead of a walk over the nodes of a std::map.
+// Keys are ordered with any_less, the total order of type then value, so keys of mixed types (and the empty any)
+// do not throw. A requires af_strict_less, lookups accept a plain key (find(42), find("name"sv)).
+// Built in bulk from unsorted input in O(n log n); insert and erase are O(n), they move the tail of the arrays.
+// The keys of one type are contiguous, the range of each type is indexed: a lookup picks the range of the type of
+// the key, then a binary search of values of the same type only, a typed loop for a plain key.
+// find_n looks up a batch of keys: grouped by type, then searched several at a time in lock step.
+// clang-format on
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "any.h"
+
+namespace ext {
+
+// sorted_keys - the sorted unique keys shared by any_sorted_set and any_sorted_map.
+template<typename A>
+class sorted_keys
+{
+public:
+    static constexpr size_t npos{static_cast<size_t>(-1)};
+    // batch_width - the number of searches find_n runs in lock step.
+    static constexpr size_t batch_width{8};
+
+    // type_range - the keys [first, last) have the same properties.
+    struct type_range
+    {
+        const typename A::any_properties* properties{nullptr};
+        uint32_t                          first{0};
+        uint32_t                          last{0};
+    };
+
+    [[nodiscard]] size_t                         size() const noexcept { return _keys.size(); }
+    [[nodiscard]] bool                           empty() const noexcept { return _keys.empty(); }
+    [[nodiscard]] const std::vector<A>&          keys() const noexcept { return _keys; }
+    [[nodiscard]] const std::vector<type_range>& type_ranges() const noexcept { return _types; }
+
+    // index_of - the position of the key, npos when missing.
+    template<typename K>
+    [[nodiscard]] size_t index_of(const K& key) const
+    {
+        const type_range* t{range_of(key)};
+        if (!t)
+        {
+            return fallback_index_of(key);
+        }
+        size_t i{npos};
+        search(*t, &key, 1, [](const K& k) { return &k; }, &i);
+        return i;
+    }
+
+    template<typename K>
+    [[nodiscard]] bool contains(const K& key) const
+    {
+        return index_of(key) != npos;
+    }
+
+    // lower_index - the position of the first key not less than key, in the order of any_less.
+    template<typename K>
+    [[nodiscard]] size_t lower_index(const K& key) const
+    {
+        return static_cast<size_t>(std::lower_bound(_keys.begin(), _keys.end(), key, any_less<A>{}) - _keys.begin());
+    }
+
+    // find_n - index_of for each key of the range, in the order of the range. The keys are grouped by type, and
+    //  the searches in the range of a type run batch_width at a time in lock step: the loads of a step do not
+    //  depend on each other, their cache misses overlap. The key positions are kept as uint32_t: a range of more
+    //  than UINT32_MAX keys throws std::length_error.
+    template<typename R>
+        requires std::ranges::random_access_range<const R> && std::ranges::sized_range<const R>
+    [[nodiscard]] std::vector<size_t> find_n(const R& keys) const
+    {
+        using difference = std::ranges::range_difference_t<const R>;
+        const size_t n{static_cast<size_t>(std::ranges::size(keys))};
+        if (n > UINT32_MAX)
+        {
+            throw std::length_error("ext::sorted_keys::find_n: more than UINT32_MAX keys");
+        }
+        auto                first{std::ranges::begin(keys)};
+        const auto          key = [&](uint32_t i) { return &first[static_cast<difference>(i)]; };
+        std::vector<size_t> out(n, npos);
+
+        // the positions of the keys of each type range, a counting sort as in for_each_batched.
+        std::vector<uint32_t> range_of_key(n);
+        std::vector<uint32_t> offsets(_types.size() + 1, 0);
+        const uint32_t        missing{static_cast<uint32_t>(_types.size())};
+        const type_range*     last{nullptr};
+        for (uint32_t i{0}; i < n; ++i)
+        {
+            if (!last || !in_range(*last, *key(i)))
+            {
+                last = range_of(*key(i));
+            }
+            range_of_key[i] = last ? static_cast<uint32_t>(last - _types.data()) : missing;
+            if (last)
+            {
+                ++offsets[range_of_key[i] + 1];
+            }
+            else
+            {
+                out[i] = fallback_index_of(*key(i));
+            }
+        }
+        for (size_t r{1}; r < offsets.size(); ++r) offsets[r] += offsets[r - 1];
+        std::vector<uint32_t> grouped(offsets.back());
+        std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for (uint32_t i{0}; i < n; ++i)
+        {
+            if (range_of_key[i] != missing) grouped[next[range_of_key[i]]++] = i;
+        }
+
+        std::vector<size_t> found(grouped.size());
+        for (size_t r{0}; r < _types.size(); ++r)
+        {
+            const size_t count{offsets[r + 1] - offsets[r]};
+            search(_types[r], grouped.data() + offsets[r], count, key, found.data() + offsets[r]);
+        }
+        for (size_t g{0}; g < grouped.size(); ++g) out[grouped[g]] = found[g];
+        return out;
+    }
+
+protected:
+    sorted_keys() = default;
+
+    // index_types - the range of each type, after the keys changed.
+    void index_types()
+    {
+        _types.clear();
+        for (uint32_t i{0}; i < _keys.size(); ++i)
+        {
+            if (_types.empty() || _types.back().properties != _keys[i].properties())
+            {
+                _types.push_back(type_range{_keys[i].properties(), i, i});
+            }
+            ++_types.back().last;
+        }
+    }
+
+    // sorted_unique - the positions of items, ordered by key, the first of equal keys only.
+    template<typename Key>
+    static std::vector<uint32_t> sorted_unique(size_t n, Key&& key)
+    {
+        if (n > UINT32_MAX)
+        {
+            throw std::length_error("ext::sorted_keys is full");
+        }
+        std::vector<uint32_t> order(n);
+        std::iota(order.begin(), order.end(), uint32_t{0});
+        const any_less<A> key_less{};
+        std::ranges::stable_sort(order, [&](uint32_t a, uint32_t b) { return key_less(key(a), key(b)); });
+        const auto last{std::ranges::unique(order, [&](uint32_t a, uint32_t b) { return !key_less(key(a), key(b)); })};
+        order.erase(last.begin(), last.end());
+        return order;
+    }
+
+    template<typename K>
+    [[nodiscard]] size_t match(size_t i, const K& key) const
+    {
+        return i < _keys.size() && !any_less<A>{}(key, _keys[i]) ? i : npos;
+    }
+
+    std::vector<A>          _keys;
+    std::vector<type_range> _types;
+
+private:
+    // in_range - the key is of the type of the range t: the same properties, or the plain key type.
+    template<typename K>
+    [[nodiscard]] bool in_range(const type_range& t, const K& key) const noexcept
+    {
+        if constexpr (is_an_any_v<K>)
+            return t.properties == key.properties();
+        else
+            return _keys[t.first].template holds<any_key_t<K>>();
+    }
+
+    template<typename K>
+    [[nodiscard]] const type_range* range_of(const K& key) const noexcept
+    {
+        for (const auto& t : _types)
+        {
+            if (in_range(t, key)) return &t;
+        }
+        return nullptr;
+    }
+
+    // fallback_index_of - the key has no type range: an any whose properties were instantiated in another shared
+    //  object, searched with any_less, or a key of a type not in the keys.
+    template<typename K>
+    [[nodiscard]] size_t fallback_index_of(const K& key) const
+    {
+        if constexpr (is_an_any_v<K>)
+            return key.has_value() ? match(lower_index(key), key) : npos;
+        else
+            return npos;
+    }
+
+    // search - out[j] = the position of the key key(keys[j]) in the range t, or npos, for count keys of the type
+    //  of t. A binary search without branches on the compares (conditional moves), batch_width keys in lock step.
+    //  The compares are the _strict_less of the range for the anys, a typed loop for the plain keys.
+    template<typename Index, typename Key>
+    void search(const type_range& t, const Index* keys, size_t count, Key&& key, size_t* out) const
+    {
+        using K = std::remove_cvref_t<decltype(*key(keys[0]))>;
+        const size_t size{t.last - t.first};
+        const A*     first{_keys.data() + t.first};
+        if constexpr (is_an_any_v<K>)
+        {
+            if (!t.properties)
+            {
+                std::fill_n(out, count, size_t{t.first});  // the keys are unique, one empty any.
+                return;
+            }
+            const auto less{t.properties->_strict_less};
+            search_n(first, size, keys, count, key, out, [less](const A& a, const K& k) { return less(a, k); },
+                     [less](const K& k, const A& a) { return less(k, a); });
+        }
+        else
+        {
+            using T = any_key_t<K>;
+            search_n(first, size, keys, count, key, out,
+                     [](const A& a, const K& k) { return unchecked_any_cast<T>(a) < k; },
+                     [](const K& k, const A& a) { return k < unchecked_any_cast<T>(a); });
+        }
+        for (size_t j{0}; j < count; ++j)
+        {
+            if (out[j] != npos) out[j] += t.first;
+        }
+    }
+
+    template<typename Index, typename Key, typename Less, typename Greater>
+    static void search_n(const A* first, size_t size, const Index* keys, size_t count, Key& key, size_t* out,
+                         Less less, Greater greater)
+    {
+        for (size_t b{0}; b < count; b += batch_width)
+        {
+            const size_t width{std::min(batch_width, count - b)};
+            const A*     base[batch_width];
+            std::fill_n(base, width, first);
+            size_t n{size};
+            while (n > 1)
+            {
+                const size_t half{n / 2};
+                for (size_t j{0}; j < width; ++j)
+                {
+                    base[j] = less(base[j][half - 1], *key(keys[b + j])) ? base[j] + half : base[j];
+                }
+                n -= half;
+            }
+            for (size_t j{0}; j < width; ++j)
+            {
+                const auto&  k{*key(keys[b + j])};
+                const size_t i{static_cast<size_t>(base[j] - first) + (size > 0 && less(*base[j], k) ? 1 : 0)};
+                out[b + j] = i < size && !greater(k, first[i]) ? i : npos;
+            }
+        }
+    }
+};
+
+template<typename A>
+class any_sorted_set : public sorted_keys<A>
+{
+    using base = sorted_keys<A>;
+
+public:
+    using value_type     = A;
+    using const_iterator = typename std::vector<A>::const_iterator;
+    using base::npos;
+
+    any_sorted_set() = default;
+
+    // any_sorted_set(values) - bulk build, sorts the values and drops the duplicates.
+    explicit any_sorted_set(std::vector<A> values)
+    {
+        const auto order{base::sorted_unique(values.size(), [&](uint32_t i) -> const A& { return values[i]; })};
+        this->_keys.reserve(order.size());
+        for (const uint32_t i : order) this->_keys.push_back(std::move(values[i]));
+        this->index_types();
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return this->_keys.begin(); }
+    [[nodiscard]] const_iterator end() const noexcept { return this->_keys.end(); }
+    [[nodiscard]] const A&       operator[](size_t i) const noexcept { return this->_keys[i]; }
+
+    template<typename K>
+    [[nodiscard]] const_iterator find(const K& key) const
+    {
+        const size_t i{this->index_of(key)};
+        return i == npos ? end() : begin() + static_cast<ptrdiff_t>(i);
+    }
+
+    std::pair<const_iterator, bool> insert(A value)
+    {
+        const size_t i{this->lower_index(value)};
+        const auto   it{begin() + static_cast<ptrdiff_t>(i)};
+        if (this->match(i, value) != npos)
+        {
+            return {it, false};
+        }
+        const auto inserted{this->_keys.insert(it, std::move(value))};
+        this->index_types();
+        return {inserted, true};
+    }
+
+    template<typename K>
+    size_t erase(const K& key)
+    {
+        const size_t i{this->index_of(key)};
+        if (i == npos)
+        {
+            return 0;
+        }
+        this->_keys.erase(this->_keys.begin() + static_cast<ptrdiff_t>(i));
+        this->index_types();
+        return 1;
+    }
+
+    void clear() noexcept
+    {
+        this->_keys.clear();
+        this->_types.clear();
+    }
+};
+
+// any_sorted_map - the keys and the values are kept in two arrays, the searches touch the keys only.
+template<typename A, typename V>
+class any_sorted_map : public sorted_keys<A>
+{
+    using base = sorted_keys<A>;
+
+public:
+    using key_type    = A;
+    using mapped_type = V;
+    using base::npos;
+
+    any_sorted_map() = default;
+
+    // any_sorted_map(items) - bulk build, sorts the items by key, of equal keys the first one is kept.
+    explicit any_sorted_map(std::vector<std::pair<A, V>> items)
+    {
+        const auto order{base::sorted_unique(items.size(), [&](uint32_t i) -> const A& { return items[i].first; })};
+        this->_keys.reserve(order.size());
+        _values.reserve(order.size());
+        for (const uint32_t i : order)
+        {
+            this->_keys.push_back(std::move(items[i].first));
+            _values.push_back(std::move(items[i].second));
+        }
+        this->index_types();
+    }
+
+    [[nodiscard]] const std::vector<V>& values() const noexcept { return _values; }
+    [[nodiscard]] const A&              key(size_t i) const noexcept { return this->_keys[i]; }
+    [[nodiscard]] V&                    value(size_t i) noexcept { return _values[i]; }
+    [[nodiscard]] const V&              value(size_t i) const noexcept { return _values[i]; }
+
+    // find - the value of the key, nullptr when missing.
+    template<typename K>
+    [[nodiscard]] V* find(const K& key)
+    {
+        const size_t i{this->index_of(key)};
+        return i == npos ? nullptr : &_values[i];
+    }
+    template<typename K>
+    [[nodiscard]] const V* find(const K& key) const
+    {
+        const size_t i{this->index_of(key)};
+        return i == npos ? nullptr : &_values[i];
+    }
+
+    template<typename K>
+    [[nodiscard]] V& at(const K& key)
+    {
+        if (V* v{find(key)}) return *v;
+        throw std::out_of_range("any_sorted_map::at");
+    }
+    template<typename K>
+    [[nodiscard]] const V& at(const K& key) const
+    {
+        if (const V* v{find(key)}) return *v;
+        throw std::out_of_range("any_sorted_map::at");
+    }
+
+    // try_emplace - inserts (key, V(args...)) when key is missing, returns the position of the key.
+    template<typename... Args>
+    std::pair<size_t, bool> try_emplace(A key, Args&&... args)
+    {
+        const size_t i{this->lower_index(key)};
+        if (this->match(i, key) != npos)
+        {
+            return {i, false};
+        }
+        const auto key_it{this->_keys.insert(this->_keys.begin() + static_cast<ptrdiff_t>(i), std::move(key))};
+        try
+        {
+            _values.emplace(_values.begin() + static_cast<ptrdiff_t>(i), std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            this->_keys.erase(key_it);
+            throw;
+        }
+        this->index_types();
+        return {i, true};
+    }
+
+    template<typename M>
+    std::pair<size_t, bool> insert_or_assign(A key, M&& value)
+    {
+        const auto r{try_emplace(std::move(key), std::forward<M>(value))};
+        if (!r.second)
+        {
+            _values[r.first] = std::forward<M>(value);
+        }
+        return r;
+    }
+
+    V& operator[](A key) { return _values[try_emplace(std::move(key)).first]; }
+
+    template<typename K>
+    size_t erase(const K& key)
+    {
+        const size_t i{this->index_of(key)};
+        if (i == npos)
+        {
+            return 0;
+        }
+        this->_keys.erase(this->_keys.begin() + static_cast<ptrdiff_t>(i));
+        _values.erase(_values.begin() + static_cast<ptrdiff_t>(i));
+        this->index_types();
+        return 1;
+    }
+
+    void clear() noexcept
+    {
+        this->_keys.clear();
+        this->_types.clear();
+        _values.clear();
+    }
+
+    // for_each - f(key, value) in key order.
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t i{0}; i < _values.size(); ++i) f(this->_keys[i], _values[i]);
+    }
+
+private:
+    std::vector<V> _values;
+};
+
+}  // namespace ext
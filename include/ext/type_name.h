@@ -1,6 +1,7 @@
 // Based on, copy paste from: https://rodusek.com/posts/2021/03/09/getting-an-unmangled-type-name-at-compile-time/
 #pragma once
 #include <array>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -58,4 +59,18 @@ constexpr auto src_type_name(T) -> std::string_view
 {
     return src_type_name<T>();
 }
+
+// type_fingerprint<T> - a 64 bits id of T, the FNV-1a of src_type_name<T>(). A compile time constant, the same in every
+//  translation unit, shared object and process built with the same compiler, so it can be a case label, or the type
+//  id of data shared between processes. Never 0, which stands for no type.
+template<typename T>
+constexpr auto type_fingerprint() -> uint64_t
+{
+    uint64_t h{0xcbf29ce484222325ULL};
+    for (const char c : src_type_name<T>())
+    {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return h ? h : 1;
+}
 }  // namespace ext
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_algorithm.h>
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using algo_any = ext::any<16, ext::af_strict_hash, ext::af_streamed>;
+
+TEST(TestAnyAlgorithm, BatchesByType)
+{
+    std::vector<algo_any> v;
+    for (int i{0}; i < 30; ++i)
+    {
+        switch (i % 3)
+        {
+        case 0: v.emplace_back(i); break;
+        case 1: v.emplace_back(std::string(40, static_cast<char>('a' + i % 26))); break;
+        default: v.emplace_back(); break;
+        }
+    }
+
+    size_t              batches{0};
+    std::vector<size_t> seen;
+    ext::for_each_batched(v, [&](const auto& batch) {
+        ++batches;
+        EXPECT_EQ(batch.size(), 10U);
+        for (size_t k{0}; k < batch.size(); ++k)
+        {
+            seen.push_back(batch.index(k));
+            EXPECT_EQ(batch[k].properties(), batch.properties());
+            if (k)
+            {
+                EXPECT_LT(batch.index(k - 1), batch.index(k));
+            }
+        }
+    });
+    EXPECT_EQ(batches, 3U);
+    std::sort(seen.begin(), seen.end());
+    for (size_t i{0}; i < seen.size(); ++i) EXPECT_EQ(seen[i], i);
+}
+
+TEST(TestAnyAlgorithm, TypedKernels)
+{
+    std::vector<algo_any> v;
+    for (int i{0}; i < 100; ++i)
+    {
+        if (i % 2)
+            v.emplace_back(i);
+        else
+            v.emplace_back(std::to_string(i));
+    }
+
+    int    sum{0};
+    size_t chars{0};
+    ext::for_each_batched(v, [&](const auto& batch) {
+        if (batch.template holds<int>())
+            batch.template for_each<int>([&](int x) { sum += x; });
+        else
+            batch.template for_each<std::string>([&](const std::string& s) { chars += s.size(); });
+    });
+    EXPECT_EQ(sum, 2500);
+    EXPECT_EQ(chars, 5U + 45U * 2U);
+
+    int                 typed_sum{0};
+    std::vector<size_t> hashes;
+    ext::for_each_batched<int>(v, [&](const auto& x) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(x)>, int>)
+            typed_sum += x;
+        else
+            hashes.push_back(x.get_hash());
+    });
+    EXPECT_EQ(typed_sum, 2500);
+    EXPECT_EQ(hashes.size(), 50U);
+    EXPECT_EQ(hashes[0], std::hash<std::string>{}("0"));
+
+    std::stringstream ss;
+    ext::for_each_batched(v, [&](const auto& batch) {
+        batch.for_each([&](const algo_any& a) { ss << a << ' '; });
+    });
+    EXPECT_TRUE(ss.str().starts_with("0 2 4 "));
+}
+
+TEST(TestAnyAlgorithm, MutableRange)
+{
+    std::vector<ext::any<16>> v;
+    for (int i{0}; i < 20; ++i)
+    {
+        v.emplace_back(i);
+        v.emplace_back(static_cast<double>(i));
+    }
+    ext::for_each_batched<int, double>(v, [](auto& x) {
+        if constexpr (std::is_arithmetic_v<std::remove_cvref_t<decltype(x)>>) x *= 2;
+    });
+    EXPECT_EQ(any_cast<int>(v[38]), 38);
+    EXPECT_EQ(any_cast<double>(v[39]), 38.0);
+}
+
+TEST(TestAnyAlgorithm, TooLargeRange)
+{
+    // the positions are uint32_t: a larger range throws before anything is allocated or visited.
+    const auto huge{std::views::iota(uint64_t{0}, uint64_t{1} << 32) |
+                    std::views::transform([](uint64_t) { return ext::any<16>{}; })};
+    bool visited{false};
+    EXPECT_THROW(ext::for_each_batched(huge, [&](const auto&) { visited = true; }), std::length_error);
+    EXPECT_FALSE(visited);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_archive.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct quote
+{
+    int64_t id;
+    double  bid;
+    double  ask;
+};
+}  // namespace
+
+template<>
+struct ext::is_bitwise_serializable<quote> : std::true_type
+{
+};
+
+namespace {
+using record_any = ext::any<16, ext::af_serialize>;
+
+std::vector<std::byte> archive_of(const std::vector<record_any>& values)
+{
+    std::ostringstream os;
+    const size_t       size{ext::write_archive(os, values)};
+    const std::string  text{os.str()};
+    EXPECT_EQ(size, text.size());
+    std::vector<std::byte> bytes(text.size());
+    std::memcpy(bytes.data(), text.data(), text.size());
+    return bytes;
+}
+}  // namespace
+
+TEST(TestAnyArchive, ViewInPlace)
+{
+    std::vector<record_any> values;
+    for (int i{0}; i < 100; ++i)
+    {
+        values.emplace_back(quote{i, i - 0.5, i + 0.5});
+        values.emplace_back(static_cast<int64_t>(i) * 3);
+        values.emplace_back(std::string(static_cast<size_t>(i % 20), 's'));
+        values.emplace_back();
+    }
+    const std::vector<std::byte> bytes{archive_of(values)};
+
+    ext::any_registry<record_any> registry;
+    registry.add<quote, int64_t, std::string>();
+    const ext::any_archive_view<record_any> view{bytes, registry};
+    ASSERT_EQ(view.size(), values.size());
+    for (size_t i{0}; i < view.size(); i += 4)
+    {
+        const auto q{view[i]};
+        ASSERT_TRUE(q.holds<quote>());
+        EXPECT_EQ(q.properties(), values[i].properties());
+        EXPECT_EQ(q.src_type_name(), values[i].src_type_name());
+        const quote& value{q.get<quote>()};
+        EXPECT_EQ(value.id, any_cast<quote>(values[i]).id);
+        EXPECT_EQ(value.ask, any_cast<quote>(values[i]).ask);
+        // in place: the value is in the archive bytes
+        EXPECT_GE(reinterpret_cast<const std::byte*>(&value), bytes.data());
+        EXPECT_LT(reinterpret_cast<const std::byte*>(&value), bytes.data() + bytes.size());
+
+        EXPECT_EQ(view[i + 1].get<int64_t>(), any_cast<int64_t>(values[i + 1]));
+        EXPECT_EQ(view[i + 1].get_if<quote>(), nullptr);
+        EXPECT_THROW((void)view[i + 1].get<double>(), std::bad_any_cast);
+
+        EXPECT_EQ(any_cast<std::string>(view[i + 2].load()), any_cast<std::string>(values[i + 2]));
+        EXPECT_FALSE(view[i + 3].has_value());
+        EXPECT_EQ(view[i + 3].properties(), nullptr);
+        EXPECT_FALSE(view[i + 3].load().has_value());
+    }
+    EXPECT_THROW((void)view.at(view.size()), std::out_of_range);
+}
+
+TEST(TestAnyArchive, InvalidArchive)
+{
+    ext::any_registry<record_any> registry;
+    registry.add<int64_t>();
+
+    const std::vector<std::byte> empty{archive_of({})};
+    EXPECT_TRUE((ext::any_archive_view<record_any>{empty, registry}.empty()));
+
+    std::vector<std::byte> bytes{archive_of({record_any{int64_t{1}}, record_any{2.5}})};
+    const ext::any_archive_view<record_any> view{bytes, registry};
+    EXPECT_EQ(view[0].get<int64_t>(), 1);
+    EXPECT_FALSE(view[1].holds<double>());  // not in the registry
+    EXPECT_THROW((void)view[1].load(), std::runtime_error);
+
+    std::vector<std::byte> truncated{bytes.begin(), bytes.end() - 8};
+    EXPECT_THROW((ext::any_archive_view<record_any>{truncated, registry}), std::runtime_error);
+
+    bytes[16] = std::byte{0xFF};  // the type id of the first record no longer matches the type table
+    const ext::any_archive_view<record_any> corrupted{bytes, registry};
+    EXPECT_THROW((void)corrupted[0], std::runtime_error);
+}
+
+TEST(TestAnyArchive, PayloadNotOfTheType)
+{
+    ext::any_registry<record_any> registry;
+    registry.add<quote, int64_t>();
+
+    // the payload size of the quote record (after the 16 bytes archive header and its type id) shrunk to 16 bytes:
+    //  the record is still within the records, of type quote, but not a quote to read in place.
+    std::vector<std::byte> bytes{archive_of({record_any{quote{1, 2.5, 3.5}}, record_any{int64_t{7}}})};
+    const uint32_t         short_size{16};
+    std::memcpy(bytes.data() + 16 + sizeof(uint64_t), &short_size, sizeof(short_size));
+    const ext::any_archive_view<record_any> corrupted{bytes, registry};
+    ASSERT_TRUE(corrupted[0].holds<quote>());
+    EXPECT_EQ(corrupted[0].get_if<quote>(), nullptr);
+    EXPECT_THROW((void)corrupted[0].get<quote>(), std::runtime_error);
+    EXPECT_THROW((void)corrupted[0].load(), std::runtime_error);
+    EXPECT_EQ(corrupted[1].get<int64_t>(), 7);
+
+    // a record not 8 bytes aligned (the view rejects such bytes, a record_ref does not): no value in place.
+    alignas(8) std::byte shifted[4 + 24]{};
+    std::memcpy(shifted + 4, bytes.data() + 16 + 40, 24);  // the int64_t record, after the quote record
+    const ext::any_record_ref<record_any> misaligned{shifted + 4, sizeof(int64_t),
+                                                     record_any::properties_of<int64_t>(), &registry};
+    ASSERT_TRUE(misaligned.holds<int64_t>());
+    EXPECT_EQ(misaligned.get_if<int64_t>(), nullptr);
+    EXPECT_THROW((void)misaligned.get<int64_t>(), std::runtime_error);
+    EXPECT_EQ(any_cast<int64_t>(misaligned.load()), 7);
+}
+
+TEST(TestAnyArchive, MappedFile)
+{
+    const std::filesystem::path path{std::filesystem::temp_directory_path() / "ext_any_archive_gtest.anys"};
+    std::vector<record_any>     values;
+    for (int i{0}; i < 1000; ++i) values.emplace_back(static_cast<double>(i) / 4);
+    {
+        std::ofstream os{path, std::ios::binary};
+        ext::write_archive(os, values);
+    }
+    {
+        ext::any_registry<record_any> registry;
+        registry.add<double>();
+        const ext::mapped_file                  file{path};
+        const ext::any_archive_view<record_any> view{file.bytes(), registry};
+        double                                  sum{0};
+        for (size_t i{0}; i < view.size(); ++i) sum += view[i].get<double>();
+        EXPECT_EQ(sum, 999.0 * 1000 / 2 / 4);
+    }
+    std::filesystem::remove(path);
+    EXPECT_THROW(ext::mapped_file{path}, std::system_error);
+}
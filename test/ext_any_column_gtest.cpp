@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_column.h>
+#include <sstream>
+#include <string>
+
+using column_any = ext::any<16, ext::af_strict_eq, ext::af_strict_hash, ext::af_strict_add, ext::af_streamed>;
+
+TEST(TestAnyColumn, GroupsByType)
+{
+    ext::any_column<column_any> column;
+    for (int i{0}; i < 10; ++i)
+    {
+        EXPECT_EQ(column.push_back(column_any{i}), static_cast<size_t>(3 * i));
+        column.push_back(column_any{std::string(static_cast<size_t>(i) + 20, 'x')});
+        column.emplace_back<double>(i * 0.5);
+    }
+    EXPECT_EQ(column.size(), 30U);
+    ASSERT_EQ(column.runs().size(), 3U);
+    for (const auto& r : column.runs())
+    {
+        EXPECT_EQ(r.values.size(), 10U);
+    }
+    EXPECT_EQ(any_cast<int>(column[9]), 3);
+    EXPECT_EQ(any_cast<std::string>(column[10]).size(), 23U);
+    EXPECT_EQ(any_cast<double>(column.at(29)), 4.5);
+    EXPECT_THROW((void)column.at(30), std::out_of_range);
+}
+
+TEST(TestAnyColumn, BulkOperations)
+{
+    ext::any_column<column_any> column;
+    for (int i{0}; i < 100; ++i)
+    {
+        column.push_back(column_any{i % 10});
+        column.push_back(column_any{std::to_string(i % 7)});
+    }
+
+    const auto hashes{column.hashes()};
+    ASSERT_EQ(hashes.size(), column.size());
+    for (size_t i{0}; i < column.size(); ++i)
+    {
+        EXPECT_EQ(hashes[i], column[i].get_hash());
+    }
+
+    EXPECT_EQ(column.count(column_any{3}), 10U);
+    EXPECT_EQ(column.count(column_any{std::string{"6"}}), 14U);
+    EXPECT_EQ(column.count(column_any{3.0}), 0U);
+
+    const auto sums = column.sums();
+    ASSERT_EQ(sums.size(), 2U);
+    EXPECT_EQ(any_cast<int>(sums[0]), 450);
+    EXPECT_EQ(any_cast<std::string>(sums[1]).size(), 100U);
+
+    ext::any_column<column_any> small;
+    small.push_back(column_any{1});
+    small.push_back(column_any{std::string{"a"}});
+    small.push_back(column_any{2});
+    std::stringstream ss;
+    small.write(ss, ",");
+    EXPECT_EQ(ss.str(), "1,2,a");
+}
+
+TEST(TestAnyColumn, SetMovesBetweenRuns)
+{
+    ext::any_column<column_any> column;
+    for (int i{0}; i < 6; ++i)
+    {
+        column.push_back(column_any{i});
+    }
+    column.set(1, column_any{std::string(40, 's')});
+    column.set(2, column_any{7});
+    EXPECT_EQ(column.size(), 6U);
+    EXPECT_EQ(any_cast<std::string>(column[1]).size(), 40U);
+    EXPECT_EQ(any_cast<int>(column[2]), 7);
+    EXPECT_EQ(any_cast<int>(column[5]), 5);
+    EXPECT_EQ(column.runs()[0].values.size(), 5U);
+
+    const auto hashes{column.hashes()};
+    for (size_t i{0}; i < column.size(); ++i)
+    {
+        EXPECT_EQ(hashes[i], column[i].get_hash());
+    }
+
+    ext::any_column<column_any> copy{column};
+    column.clear();
+    EXPECT_TRUE(column.empty());
+    EXPECT_EQ(any_cast<std::string>(copy[1]).size(), 40U);
+
+    // the run of the empty anys stays in runs() once emptied, it has no hash to refuse.
+    ext::any_column<column_any> replaced;
+    replaced.push_back(column_any{});
+    EXPECT_THROW((void)replaced.hashes(), std::runtime_error);
+    replaced.set(0, column_any{5});
+    const auto replaced_hashes{replaced.hashes()};
+    ASSERT_EQ(replaced_hashes.size(), 1U);
+    EXPECT_EQ(replaced_hashes[0], column_any{5}.get_hash());
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <ext/any_flat_map.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+using key_any = ext::any<16, ext::af_strict_hash, ext::af_strict_eq>;
+using namespace std::string_view_literals;
+
+TEST(TestAnyFlatMap, InsertFindErase)
+{
+    ext::any_flat_map<key_any, int> m;
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(m.find(1), m.end());
+
+    for (int i{0}; i < 1000; ++i)
+    {
+        EXPECT_TRUE(m.try_emplace(key_any{i}, i).second);
+        EXPECT_TRUE(m.try_emplace(key_any{std::to_string(i)}, -i).second);
+    }
+    EXPECT_FALSE(m.try_emplace(key_any{5}, 0).second);
+    EXPECT_EQ(m.size(), 2000U);
+
+    for (int i{0}; i < 1000; ++i)
+    {
+        ASSERT_NE(m.find(i), m.end());
+        EXPECT_EQ(m.find(i)->second, i);
+        EXPECT_EQ(m.at(std::to_string(i)), -i);
+    }
+    EXPECT_EQ(m.at("77"sv), -77);
+    EXPECT_EQ(m.at("77"), -77);
+    EXPECT_FALSE(m.contains(1000));
+    EXPECT_FALSE(m.contains(5L));  // a long key is not an int key.
+    EXPECT_THROW((void)m.at(2.5), std::out_of_range);
+
+    for (int i{0}; i < 1000; i += 2)
+    {
+        EXPECT_EQ(m.erase(i), 1U);
+    }
+    EXPECT_EQ(m.erase(0), 0U);
+    EXPECT_EQ(m.size(), 1500U);
+    EXPECT_FALSE(m.contains(10));
+    EXPECT_TRUE(m.contains(11));
+
+    size_t n{0};
+    for (const auto& [k, v] : m)
+    {
+        if (k.holds<int>())
+        {
+            EXPECT_EQ(any_cast<int>(k), v);
+        }
+        ++n;
+    }
+    EXPECT_EQ(n, m.size());
+}
+
+TEST(TestAnyFlatMap, MixedAndEmptyKeys)
+{
+    ext::any_flat_map<key_any, std::string> m;
+    m[key_any{}]       = "empty";
+    m[key_any{1}]      = "int";
+    m[key_any{1L}]     = "long";
+    m[key_any{1.0}]    = "double";
+    m[std::string{"1"}] = "string";
+    EXPECT_EQ(m.size(), 5U);
+    EXPECT_EQ(m[key_any{}], "empty");
+    EXPECT_EQ(m.at(1L), "long");
+    EXPECT_EQ(m.at(1.0), "double");
+    EXPECT_EQ(m.at("1"sv), "string");
+
+    m.insert_or_assign(1, std::string{"one"});
+    EXPECT_EQ(m.at(1), "one");
+
+    auto copy{m};
+    m.clear();
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(copy.size(), 5U);
+    EXPECT_EQ(copy.at(1), "one");
+
+    ext::any_flat_map<key_any, std::string> moved{std::move(copy)};
+    EXPECT_EQ(moved.size(), 5U);
+}
+
+TEST(TestAnyFlatMap, ChurnReusesDeletedSlots)
+{
+    ext::any_flat_map<key_any, int> m;
+    for (int round{0}; round < 50; ++round)
+    {
+        for (int i{0}; i < 100; ++i) m.try_emplace(round * 100 + i, i);
+        for (int i{0}; i < 100; ++i) EXPECT_EQ(m.erase(round * 100 + i), 1U);
+    }
+    EXPECT_TRUE(m.empty());
+    EXPECT_LE(m.capacity(), 512U);
+}
+
+// throwing_value - a value whose move may throw, its copies throw once the budget is spent.
+struct throwing_value
+{
+    static inline int copies_left{1000};
+    static inline int live{0};
+
+    int value;
+
+    explicit throwing_value(int v) : value{v} { ++live; }
+    throwing_value(const throwing_value& rhs) : value{rhs.value}
+    {
+        if (copies_left-- == 0) throw std::runtime_error("copy");
+        ++live;
+    }
+    throwing_value(throwing_value&& rhs) noexcept(false) : value{rhs.value} { ++live; }
+    throwing_value& operator=(const throwing_value&) = default;
+    ~throwing_value() { --live; }
+};
+
+TEST(TestAnyFlatMap, ConstKeysAndRehashSafety)
+{
+    ext::any_flat_map<key_any, int> m;
+    m.try_emplace(1, 10);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(m.begin()->first)>>);
+    static_assert(std::is_same_v<decltype(*m.begin()), std::pair<const key_any&, int&>>);
+    static_assert(!std::is_assignable_v<decltype((m.begin()->first)), key_any>);
+    for (auto&& [k, v] : m) v += any_cast<int>(k);
+    m.begin()->second += 1;
+    EXPECT_EQ(m.at(1), 12);
+
+    // the iterators work with the standard algorithms, and with the ranges from C++23.
+    using iterator = ext::any_flat_map<key_any, int>::iterator;
+    static_assert(std::is_same_v<std::iterator_traits<iterator>::difference_type, std::ptrdiff_t>);
+    static_assert(std::is_same_v<std::iterator_traits<iterator>::iterator_category, std::input_iterator_tag>);
+    m.try_emplace(2, 20);
+    m.try_emplace("three"sv, 30);
+    EXPECT_EQ(std::distance(m.begin(), m.end()), 3);
+    EXPECT_EQ(std::count_if(m.begin(), m.end(), [](const auto& kv) { return kv.second >= 20; }), 2);
+    const auto& cm{m};
+    const auto  it{std::find_if(cm.begin(), cm.end(), [](const auto& kv) { return kv.first == key_any{2}; })};
+    ASSERT_NE(it, cm.end());
+    EXPECT_EQ(it->second, 20);
+#if defined(__cpp_lib_ranges_zip)
+    static_assert(std::forward_iterator<iterator>);
+    static_assert(std::forward_iterator<ext::any_flat_map<key_any, int>::const_iterator>);
+    static_assert(std::ranges::forward_range<const ext::any_flat_map<key_any, int>>);
+    EXPECT_EQ(std::ranges::count_if(m, [](const auto& kv) { return kv.second >= 20; }), 2);
+    EXPECT_EQ(std::ranges::find_if(cm, [](const auto& kv) { return kv.first == key_any{2}; })->second, 20);
+#endif
+
+    // a rehash that throws leaves the elements in place.
+    ext::any_flat_map<key_any, throwing_value> t;
+    for (int i{0}; i < 14; ++i) t.try_emplace(i, i);
+    ASSERT_EQ(t.capacity(), 16U);
+    throwing_value::copies_left = 3;
+    EXPECT_THROW(t.try_emplace(14, 14), std::runtime_error);
+    throwing_value::copies_left = 1000;
+    EXPECT_EQ(t.size(), 14U);
+    EXPECT_EQ(t.capacity(), 16U);
+    for (int i{0}; i < 14; ++i) EXPECT_EQ(t.at(i).value, i);
+    EXPECT_TRUE(t.try_emplace(14, 14).second);
+    EXPECT_EQ(t.at(14).value, 14);
+
+    // a copy that throws destroys the elements it copied.
+    const int live{throwing_value::live};
+    throwing_value::copies_left = 2;
+    EXPECT_THROW((ext::any_flat_map<key_any, throwing_value>{t}), std::runtime_error);
+    throwing_value::copies_left = 1000;
+    EXPECT_EQ(throwing_value::live, live);
+    const ext::any_flat_map<key_any, throwing_value> copy{t};
+    EXPECT_EQ(copy.size(), 15U);
+    for (int i{0}; i < 15; ++i) EXPECT_EQ(copy.at(i).value, i);
+}
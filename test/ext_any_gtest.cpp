@@ -4,7 +4,10 @@
 #include <ext/any.h>
 #include <map>
 #include <memory>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -362,4 +365,798 @@ TEST(TestAny, func)
 //     }
 // };
 
-// #endif
\ No newline at end of file
+// #endif
+TEST(TestAny, AssignLvalueWithFeatures)
+{
+    using AT = ext::any<8, ext::af_strict_eq, ext::af_strict_hash>;
+    AT a0{1};
+    AT a1{2.5};
+    a0 = a1;  // non-const lvalue of the same any type: copy assignment, not a nested any.
+    EXPECT_EQ(any_cast<double>(a0), 2.5);
+    EXPECT_EQ(a0.properties(), a1.properties());
+}
+
+template<typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    static inline size_t allocations{0};
+    static inline size_t deallocations{0};
+
+    counting_allocator() = default;
+    template<typename U>
+    explicit counting_allocator(const counting_allocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        ++counting_allocator<char>::allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, size_t n)
+    {
+        ++counting_allocator<char>::deallocations;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+};
+
+TEST(TestAny, Allocator)
+{
+    using AT      = ext::any<8, ext::af_allocator<counting_allocator<char>>::template feature>;
+    using counter = counting_allocator<char>;
+    const size_t allocations{counter::allocations};
+    {
+        AT a0{std::string{"a string which does not fit in place"}};
+        AT a1{a0};
+        AT a2{std::move(a0)};
+        AT a3{12};  // in place, no allocation
+        a3.emplace<std::string>("emplaced");
+        EXPECT_EQ(any_cast<std::string>(a1), "a string which does not fit in place");
+        EXPECT_EQ(any_cast<std::string>(a2), "a string which does not fit in place");
+        EXPECT_EQ(any_cast<std::string>(a3), "emplaced");
+        EXPECT_EQ(counter::allocations - allocations, 3);
+    }
+    EXPECT_EQ(counter::allocations, counter::deallocations);
+}
+
+template<size_t S>
+struct pooled_payload
+{
+    char data[S]{};
+};
+
+TEST(TestAny, Pooled)
+{
+    using AT = ext::any<16, ext::af_pooled>;
+    AT a0{pooled_payload<48>{{'x'}}};
+    EXPECT_FALSE(a0.inplace());
+    const auto* p0{&any_cast<pooled_payload<48>>(a0)};
+    a0.reset();
+    AT a1{pooled_payload<40>{}};  // same 48 bytes size class, reuses the freed block.
+    EXPECT_EQ(static_cast<const void*>(&any_cast<pooled_payload<40>>(a1)), static_cast<const void*>(p0));
+
+    AT a2{a1};
+    EXPECT_NE(static_cast<const void*>(&any_cast<pooled_payload<40>>(a2)), static_cast<const void*>(p0));
+
+    AT a3{pooled_payload<1024>{{'y'}}};  // larger than any_pool::max_block_size, from the global heap.
+    EXPECT_EQ(any_cast<pooled_payload<1024>>(a3).data[0], 'y');
+}
+
+TEST(TestAny, PooledCrossThreadFree)
+{
+    using AT = ext::any<16, ext::af_pooled>;
+    AT          a0{pooled_payload<232>{{'z'}}};
+    const void* p0{&any_cast<pooled_payload<232>>(a0)};
+
+    std::thread t{[a = std::move(a0)]() mutable { a.reset(); }};
+    t.join();
+
+    // the block was freed by the other thread, it is drained back from this thread's remote list.
+    AT a1{pooled_payload<232>{}};
+    EXPECT_EQ(static_cast<const void*>(&any_cast<pooled_payload<232>>(a1)), p0);
+}
+
+TEST(TestAny, PooledAfterThreadCacheExit)
+{
+    using AT = ext::any<16, ext::af_pooled>;
+    // destroyed after the thread cache of the pool, constructed before it: allocates from the exit cache.
+    struct late_user
+    {
+        std::atomic<int>* copied;
+        ~late_user()
+        {
+            const AT a0{pooled_payload<64>{{'e'}}};
+            const AT a1{a0};
+            *copied += any_cast<pooled_payload<64>>(a1).data[0] == 'e';
+        }
+    };
+    std::atomic<int> copied{0};
+    for (int round{0}; round < 4; ++round)
+    {
+        std::thread t{[&copied] {
+            thread_local late_user user{&copied};
+            const AT a{pooled_payload<64>{}};
+        }};
+        t.join();
+    }
+    EXPECT_EQ(copied, 4);
+}
+
+TEST(TestAny, TriviallyCopyableFastPath)
+{
+    using AT = ext::any<16>;
+    std::vector<AT> v0;
+    for (int i{0}; i < 100; ++i)
+    {
+        if (i % 3 == 0)
+            v0.emplace_back(i);
+        else if (i % 3 == 1)
+            v0.emplace_back(double(i));
+        else
+            v0.emplace_back(std::string(40, char('a' + i % 26)));
+    }
+    EXPECT_TRUE(v0[0].cold_properties()->_is_trivially_copyable);
+    EXPECT_TRUE(v0[0].cold_properties()->_is_trivially_relocatable);
+    EXPECT_FALSE(v0[2].cold_properties()->_is_trivially_copyable);
+    EXPECT_FALSE(v0[2].cold_properties()->_is_trivially_destructible);
+    EXPECT_TRUE(v0[2].cold_properties()->_is_trivially_relocatable);
+
+    std::vector<AT> v1(v0);
+    v1.reserve(v1.capacity() * 2);  // relocation of all elements
+    v0 = v1;
+    for (int i{0}; i < 100; ++i)
+    {
+        if (i % 3 == 0)
+            EXPECT_EQ(any_cast<int>(v0[size_t(i)]), i);
+        else if (i % 3 == 1)
+            EXPECT_EQ(any_cast<double>(v1[size_t(i)]), double(i));
+        else
+            EXPECT_EQ(any_cast<std::string>(v1[size_t(i)]), std::string(40, char('a' + i % 26)));
+    }
+    AT a0{std::move(v1[2])};
+    EXPECT_FALSE(v1[2].has_value());
+    AT a1{std::move(v1[3])};
+    EXPECT_TRUE(v1[3].has_value());
+    a1 = std::move(a0);
+    EXPECT_EQ(any_cast<std::string>(a1), std::string(40, char('a' + 2)));
+}
+
+TEST(TestAny, TaggedProperties)
+{
+    using AT = ext::any<16>;
+    AT a0{};
+    AT a1{42};
+    AT a2{std::string(40, 's')};
+    AT a3{std::string("short")};
+
+    EXPECT_TRUE(a0.inplace());
+    EXPECT_FALSE(a0.trivial());
+    EXPECT_FALSE(a0.trivially_relocatable());
+    EXPECT_EQ(a0.properties(), nullptr);
+
+    EXPECT_TRUE(a1.inplace());
+    EXPECT_TRUE(a1.trivial());
+    EXPECT_TRUE(a1.trivially_relocatable());
+    EXPECT_EQ(a1.properties(), (&ext::any_properties_t_data_type<int, AT>::instance));
+
+    EXPECT_FALSE(a2.inplace());
+    EXPECT_FALSE(a2.trivial());
+    EXPECT_TRUE(a2.trivially_relocatable());
+
+    if (a3.inplace())  // std::string with SSO, in place on libstdc++ only when it fits
+    {
+        EXPECT_FALSE(a3.trivially_relocatable());
+    }
+    a1 = a3;
+    EXPECT_EQ(any_cast<std::string>(a1), "short");
+    a3 = 7;
+    a1 = a3;
+    EXPECT_EQ(any_cast<int>(a1), 7);
+}
+
+TEST(TestAny, HotColdProperties)
+{
+    using AT = ext::any<16, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash, ext::af_streamed>;
+    static_assert(sizeof(AT::any_properties) == 64);
+    AT a0{12};
+    const auto* hot{a0.properties()};
+    EXPECT_NE(hot->_strict_less, nullptr);
+    EXPECT_NE(hot->_strict_eq, nullptr);
+    EXPECT_NE(hot->_strict_hash, nullptr);
+    EXPECT_EQ(hot->_cold, a0.cold_properties());
+    EXPECT_EQ(a0.cold_properties()->_value_size, sizeof(int));
+    EXPECT_NE(a0.cold_properties()->_clone, nullptr);
+    std::ostringstream os;
+    os << a0;
+    EXPECT_EQ(os.str(), "12");
+
+    // all the hot Features pointers together and the life cycle fill the first cache line.
+    using OT = ext::any<16, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash, ext::af_three_way>;
+    static_assert(sizeof(OT::any_properties) == 64);
+    const OT o1{1};
+    EXPECT_NE(o1.properties()->_three_way, nullptr);
+    EXPECT_TRUE(o1 < OT{2});
+    EXPECT_TRUE(o1 == OT{1});
+    EXPECT_EQ(o1 <=> OT{std::string{"s"}}, OT{1} <=> OT{std::string{"t"}});
+    EXPECT_EQ(o1.get_hash(), OT{1}.get_hash());
+    EXPECT_EQ(o1.fingerprint(), ext::type_fingerprint<int>());
+}
+
+// af_hot_counter - a user Feature with one hot pointer, in the fifth Features slot of the hot cache line.
+template<typename T>
+struct af_hot_counter;
+
+template<size_t N, template<typename> class... Features>
+struct af_hot_counter<ext::any<N, Features...>>
+{
+    struct extend_properties
+    {
+        size_t (*_value_bytes)(){nullptr};
+    };
+
+    template<typename T>
+    static constexpr void construct_extend_properties(auto& prop)
+    {
+        prop._value_bytes = [] { return sizeof(T); };
+    }
+};
+
+TEST(TestAny, WidestFeatureSetHotProperties)
+{
+    // every Feature of any.h that can be combined, and a user hot pointer: the hot properties stay one cache line.
+    using WT = ext::any<24, ext::af_compact, ext::af_streamed, ext::af_to_chars, ext::af_strict_less, ext::af_strict_eq,
+                        ext::af_three_way, ext::af_strict_hash, ext::af_mixed_hash, ext::af_cached_hash,
+                        ext::af_strict_add, ext::af_pooled, af_hot_counter>;
+    static_assert(sizeof(WT::any_properties) == 64);
+
+    const WT w0{std::string(40, 'w')};
+    WT       w1{w0};
+    EXPECT_EQ(w1.properties()->_value_bytes(), sizeof(std::string));
+    EXPECT_TRUE(w0 == w1);
+    EXPECT_EQ(w0 <=> WT{1}, 0 <=> (WT{1} <=> w0));
+    EXPECT_EQ(w0.get_hash(), w1.get_hash());
+    w1 = w0 + w1;
+    EXPECT_TRUE(w0 < w1);
+    const WT w2{std::move(w1)};
+    std::ostringstream os;
+    os << w2;
+    EXPECT_EQ(os.str(), std::string(80, 'w'));
+    char       buffer[8];
+    const auto r{to_chars(std::begin(buffer), std::end(buffer), WT{12})};
+    EXPECT_EQ(std::string(buffer, r.ptr), "12");
+}
+
+TEST(TestAny, ConstantInitializedProperties)
+{
+    using AT = ext::any<16, ext::af_strict_less, ext::af_strict_eq, ext::af_strict_hash, ext::af_streamed>;
+    using PT = ext::any_properties_t_data_type<std::string, AT>;
+    static_assert(PT::instance._cold == &PT::cold_instance);
+    static_assert(PT::cold_instance._value_size == sizeof(std::string));
+    static_assert(PT::cold_instance._src_type_name.size() > 0);
+    constinit static const AT::any_properties* properties{&PT::instance};
+    AT a0{std::string{"constinit"}};
+    EXPECT_EQ(a0.properties(), properties);
+}
+
+TEST(TestAny, UncheckedCastAndTypeHandle)
+{
+    using AT = ext::any<16>;
+    std::vector<AT> v;
+    for (int i{0}; i < 10; ++i)
+    {
+        v.emplace_back(i);
+        v.emplace_back(std::string(30, 'h'));
+    }
+    EXPECT_TRUE(v[0].holds<int>());
+    EXPECT_FALSE(v[0].holds<long>());
+    EXPECT_TRUE(v[1].holds<std::string>());
+    EXPECT_EQ(unchecked_any_cast<int>(v[2]), 1);
+
+    const AT::type_handle<int> h{v[0]};
+    int                        sum{0};
+    size_t                     strings{0};
+    for (const auto& a : v)
+    {
+        if (h.holds(a))
+            sum += h.get(a);
+        else
+            strings += unchecked_any_cast<std::string>(a).size();
+    }
+    EXPECT_EQ(sum, 45);
+    EXPECT_EQ(strings, 300);
+    EXPECT_EQ(AT::type_handle<std::string>{}.get_if(v[0]), nullptr);
+    EXPECT_THROW(AT::type_handle<double>{v[0]}, std::bad_any_cast);
+}
+
+TEST(TestAny, VariantDispatch)
+{
+    struct Big
+    {
+        uint64_t data[8]{};
+        bool     operator<(const Big& rhs) const { return data[0] < rhs.data[0]; }
+        bool     operator==(const Big& rhs) const { return data[0] == rhs.data[0]; }
+    };
+    using AT = ext::any<16, ext::af_variant<int, double, std::string, Big>::template types, ext::af_strict_less,
+                        ext::af_strict_eq>;
+    static_assert(AT::closed_dispatch);
+    static_assert(AT::index_of<std::string>() == 3);
+    static_assert(AT::index_of<float>() == 0);
+
+    AT a0{};
+    EXPECT_EQ(a0.type_index(), 0U);
+    EXPECT_THROW((void)ext::visit([](const auto&) { return 0; }, a0), std::bad_any_cast);
+
+    AT a1{std::string(40, 's')};
+    AT a2{Big{{7}}};
+    AT a3{2.5};
+    EXPECT_EQ(a1.type_index(), 3U);
+    EXPECT_EQ(a2.type_index(), 4U);
+    EXPECT_FALSE(a3.holds<float>());
+
+    AT a4{a1};
+    AT a5{std::move(a2)};
+    EXPECT_TRUE(a4 == a1);
+    EXPECT_EQ(any_cast<Big>(a5).data[0], 7U);
+    a4 = a1;
+    a4 = AT{std::string(40, 't')};
+    EXPECT_TRUE(a1 < a4);
+    a4 = a3;
+    EXPECT_EQ(any_cast<double>(a4), 2.5);
+    a4.reset();
+    EXPECT_FALSE(a4.has_value());
+
+    const auto kind = [](const AT& a) {
+        return ext::visit(ext::overloaded{[](int) { return 1; }, [](double) { return 2; },
+                                          [](const std::string& s) { return static_cast<int>(s.size()); },
+                                          [](const Big& b) { return static_cast<int>(b.data[0]); }},
+                          a);
+    };
+    EXPECT_EQ(kind(AT{3}), 1);
+    EXPECT_EQ(kind(a3), 2);
+    EXPECT_EQ(kind(a1), 40);
+    EXPECT_EQ(kind(a5), 7);
+
+    ext::visit([](auto& v) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(v)>, double>)
+            v += 1.0;
+    }, a3);
+    EXPECT_EQ(any_cast<double>(a3), 3.5);
+}
+
+TEST(TestAny, CompactLayout)
+{
+    using AT = ext::any<12, ext::af_compact, ext::af_strict_eq, ext::af_strict_less, ext::af_strict_hash,
+                        ext::af_streamed>;
+    static_assert(sizeof(AT) == 16);
+    static_assert(sizeof(ext::any<4, ext::af_compact>) == 8);
+    static_assert(sizeof(AT::tag_word) == 4);
+
+    AT a0{};
+    EXPECT_FALSE(a0.has_value());
+    EXPECT_EQ(a0.properties(), nullptr);
+
+    AT a1{5};
+    AT a2{int64_t{7}};
+    AT a3{std::string(40, 'c')};
+    EXPECT_TRUE(a1.holds<int>());
+    EXPECT_FALSE(a1.holds<int64_t>());
+    EXPECT_TRUE(a2.inplace());
+    EXPECT_FALSE(a3.inplace());
+    EXPECT_EQ(a3.src_type_name(), ext::src_type_name<std::string>());
+
+    AT a4{a3};
+    EXPECT_TRUE(a4 == a3);
+    EXPECT_EQ(a4.get_hash(), std::hash<std::string>{}(std::string(40, 'c')));
+    AT a5{std::move(a4)};
+    EXPECT_EQ(any_cast<std::string>(a5).size(), 40U);
+    a5 = a1;
+    EXPECT_EQ(any_cast<int>(a5), 5);
+    a5 = AT{6};
+    EXPECT_TRUE(a1 < a5);
+
+    std::stringstream ss;
+    ss << a1 << ',' << a2 << ',' << a3.src_type_name().size();
+    EXPECT_EQ(ss.str(), "5,7," + std::to_string(ext::src_type_name<std::string>().size()));
+
+    // holds<T>() does not register T, a type_handle does: its constructor may throw.
+    struct never_stored
+    {
+    };
+    using PT = ext::any<12, ext::af_compact>;
+    const PT p0{};
+    const PT p1{5};
+    EXPECT_FALSE(p0.holds<never_stored>());
+    EXPECT_FALSE(p1.holds<never_stored>());
+    static_assert(!std::is_nothrow_default_constructible_v<PT::type_handle<never_stored>>);
+    static_assert(std::is_nothrow_default_constructible_v<ext::any<16>::type_handle<never_stored>>);
+    const PT::type_handle<never_stored> h{};
+    EXPECT_FALSE(h.holds(p0));
+    EXPECT_TRUE(h.holds(PT{never_stored{}}));
+
+    ext::any<4, ext::af_compact> small{3.5f};
+    EXPECT_EQ(any_cast<float>(small), 3.5f);
+    small = 9;
+    EXPECT_EQ(any_cast<int>(small), 9);
+
+    using VT = ext::any<12, ext::af_compact, ext::af_variant<int, double>::template types, ext::af_strict_eq>;
+    static_assert(sizeof(VT) == 16);
+    VT v0{2.5};
+    VT v1{v0};
+    EXPECT_TRUE(v1 == v0);
+    EXPECT_EQ(v1.type_index(), 2U);
+}
+
+namespace {
+// ticket - an in place value whose hash throws once it is moved from.
+struct ticket
+{
+    int id;
+
+    explicit ticket(int i) : id{i} {}
+    ticket(const ticket&) = default;
+    ticket(ticket&& rhs) noexcept : id{rhs.id} { rhs.id = -1; }
+    ticket& operator=(const ticket&) = default;
+    ticket& operator=(ticket&& rhs) noexcept
+    {
+        id     = rhs.id;
+        rhs.id = -1;
+        return *this;
+    }
+};
+}  // namespace
+template<>
+struct std::hash<ticket>
+{
+    size_t operator()(const ticket& t) const
+    {
+        if (t.id < 0) throw std::logic_error("hash of a moved-from ticket");
+        return static_cast<size_t>(t.id);
+    }
+};
+
+TEST(TestAny, CachedHash)
+{
+    using AT = ext::any<16, ext::af_strict_hash, ext::af_cached_hash, ext::af_strict_eq>;
+    static_assert(sizeof(AT) == 32);
+    static_assert(AT::in_place_capacity() == 16);
+
+    const std::string long_string(100, 'k');
+    const size_t      long_hash{std::hash<std::string>{}(long_string)};
+
+    AT a0{long_string};
+    EXPECT_EQ(a0.get_hash(), long_hash);
+    AT a1{a0};
+    EXPECT_EQ(a1.get_hash(), long_hash);
+    AT a2{std::move(a1)};
+    EXPECT_EQ(a2.get_hash(), long_hash);
+
+    AT a3{42};
+    EXPECT_EQ(a3.get_hash(), std::hash<int>{}(42));
+    a3 = a2;
+    EXPECT_EQ(a3.get_hash(), long_hash);
+    a3 = 7;
+    EXPECT_EQ(a3.get_hash(), std::hash<int>{}(7));
+    a3 = AT{std::string{"abc"}};
+    EXPECT_EQ(a3.get_hash(), std::hash<std::string>{}("abc"));
+    a3.emplace<long>(5L);
+    EXPECT_EQ(a3.get_hash(), std::hash<long>{}(5L));
+
+    any_cast<long>(a3) = 6;
+#ifndef NDEBUG
+    EXPECT_DEATH((void)a3.get_hash(), "stale hash");
+#endif
+    a3.refresh_hash();
+    EXPECT_EQ(a3.get_hash(), std::hash<long>{}(6L));
+
+    // the moved-from values left in the anys are hashed again: an in place shared_ptr, a heap string.
+    const auto shared{std::make_shared<int>(1)};
+    AT         s0{shared};
+    const AT   s1{std::move(s0)};
+    EXPECT_EQ(s1.get_hash(), std::hash<std::shared_ptr<int>>{}(shared));
+    ASSERT_TRUE(s0.has_value());
+    EXPECT_EQ(s0.get_hash(), std::hash<std::shared_ptr<int>>{}(nullptr));
+    AT a4{std::string(100, 'm')};
+    a0 = std::move(a4);
+    EXPECT_EQ(a0.get_hash(), std::hash<std::string>{}(std::string(100, 'm')));
+    ASSERT_TRUE(a4.has_value());
+    EXPECT_EQ(a4.get_hash(), std::hash<std::string>{}(any_cast<std::string>(a4)));
+
+    std::unordered_map<AT, int> m;
+    for (int i{0}; i < 100; ++i)
+    {
+        m[AT{std::to_string(i)}] = i;
+    }
+    EXPECT_EQ(m.at(AT{std::string{"42"}}), 42);
+
+    // a hash that throws on the moved-from value does not make the move throw: its cached hash is stale.
+    using TT = ext::any<16, ext::af_strict_hash, ext::af_cached_hash>;
+    std::vector<TT> tickets;
+    for (int i{0}; i < 100; ++i) tickets.emplace_back(ticket{i});
+    EXPECT_EQ(tickets[42].get_hash(), 42U);
+    TT t0{ticket{7}};
+    TT t1{std::move(t0)};
+    EXPECT_EQ(t1.get_hash(), 7U);
+    EXPECT_THROW(t0.refresh_hash(), std::logic_error);
+    t0 = std::move(t1);
+    EXPECT_EQ(t0.get_hash(), 7U);
+}
+
+TEST(TestAny, MixedHashTransparentLookup)
+{
+    using AT = ext::any<16, ext::af_strict_hash, ext::af_mixed_hash, ext::af_strict_eq>;
+    EXPECT_NE(AT{1}.get_hash(), AT{1L}.get_hash());
+    EXPECT_NE(AT{1}.get_hash(), std::hash<int>{}(1));
+
+    // sequential integers spread over the low bits.
+    std::set<size_t> low_bits;
+    for (int i{0}; i < 64; ++i)
+    {
+        low_bits.insert(AT{i * 1024}.get_hash() & 63);
+    }
+    EXPECT_GT(low_bits.size(), 32U);
+
+    using map_type = std::unordered_map<AT, int, ext::any_hash<AT>, ext::any_equal_to<AT>>;
+    map_type m;
+    m[AT{std::string{"alpha"}}] = 1;
+    m[AT{42}]                   = 2;
+    m[AT{42L}]                  = 3;
+    EXPECT_EQ(m.size(), 3U);
+
+    using namespace std::string_view_literals;
+    ASSERT_NE(m.find("alpha"sv), m.end());
+    EXPECT_EQ(m.find("alpha"sv)->second, 1);
+    EXPECT_EQ(m.find("alpha")->second, 1);
+    EXPECT_EQ(m.find(42)->second, 2);
+    EXPECT_EQ(m.find(42L)->second, 3);
+    EXPECT_EQ(m.find(43), m.end());
+    EXPECT_EQ(m.find("beta"sv), m.end());
+    EXPECT_EQ(ext::any_hash<AT>{}("alpha"sv), AT{std::string{"alpha"}}.get_hash());
+
+    using CT = ext::any<16, ext::af_strict_hash, ext::af_mixed_hash, ext::af_cached_hash>;
+    EXPECT_EQ(CT{std::string{"alpha"}}.get_hash(), AT{std::string{"alpha"}}.get_hash());
+}
+
+TEST(TestAny, ThreeWayCompare)
+{
+    using AT = ext::any<16, ext::af_three_way>;
+    std::vector<AT> v{AT{3}, AT{std::string{"b"}}, AT{}, AT{1.5}, AT{1}, AT{std::string{"a"}}, AT{}, AT{-0.5}, AT{2}};
+    EXPECT_NO_THROW(std::sort(v.begin(), v.end()));
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+    EXPECT_FALSE(v[0].has_value());
+    EXPECT_FALSE(v[1].has_value());
+    EXPECT_TRUE(v[0] == v[1]);
+    for (size_t i{2}; i + 1 < v.size(); ++i)
+    {
+        EXPECT_TRUE(v[i] <= v[i + 1]);
+        if (v[i].properties() == v[i + 1].properties())
+        {
+            EXPECT_TRUE(v[i] < v[i + 1]);
+        }
+    }
+
+    EXPECT_EQ(AT{1} <=> AT{2}, std::weak_ordering::less);
+    EXPECT_EQ(AT{2} <=> AT{2}, std::weak_ordering::equivalent);
+    EXPECT_TRUE(AT{2} == AT{2});
+    EXPECT_TRUE(AT{2} != AT{2L});
+    EXPECT_EQ(AT{} <=> AT{0}, std::weak_ordering::less);
+    EXPECT_EQ(AT{1} < AT{1.0}, AT{1.0} > AT{1});
+    EXPECT_NE(AT{1} < AT{1.0}, AT{1.0} < AT{1});
+
+    // with af_strict_eq the throwing '==' is kept, <=> is still total.
+    using ET = ext::any<16, ext::af_strict_eq, ext::af_three_way>;
+    EXPECT_THROW((void)(ET{1} == ET{1.0}), std::runtime_error);
+    EXPECT_NE(ET{1} <=> ET{1.0}, std::weak_ordering::equivalent);
+
+    using VT = ext::any<16, ext::af_variant<int, double>::template types, ext::af_three_way>;
+    EXPECT_TRUE(VT{1} < VT{2});
+    EXPECT_TRUE(VT{2.0} > VT{1.0});
+}
+
+// key - a type with the same name in ext_any_gtest_tu2.cpp, of another layout.
+namespace {
+struct key
+{
+    std::string text;
+    friend auto operator<=>(const key&, const key&) = default;
+};
+}  // namespace
+
+using same_name_any = ext::any<16, ext::af_strict_less, ext::af_three_way>;
+same_name_any other_tu_key(int64_t value);
+
+TEST(TestAny, SameNameTypesOfTwoTranslationUnits)
+{
+    const same_name_any a{key{std::string(40, 'k')}};
+    const same_name_any b{other_tu_key(7)};
+    ASSERT_EQ(a.src_type_name(), b.src_type_name());
+    ASSERT_EQ(a.fingerprint(), b.fingerprint());
+    EXPECT_NE(a.properties(), b.properties());
+    EXPECT_FALSE(b.holds<key>());
+
+    // ordered by type, the _three_way of one type is never called on the value of the other.
+    const auto ab{a <=> b};
+    EXPECT_NE(ab, std::weak_ordering::equivalent);
+    EXPECT_EQ(b <=> a, 0 <=> ab);
+    EXPECT_FALSE(a == b);
+    EXPECT_EQ(a <=> same_name_any{key{"k"}}, std::weak_ordering::greater);
+    EXPECT_EQ(b <=> other_tu_key(8), std::weak_ordering::less);
+
+    const ext::any_less<same_name_any> less{};
+    EXPECT_EQ(less(a, b), ab < 0);
+    EXPECT_EQ(less(b, a), ab > 0);
+    EXPECT_TRUE(less(b, other_tu_key(8)));
+
+    // any_less and af_three_way order the types alike.
+    const std::vector<same_name_any> v{same_name_any{3}, same_name_any{std::string{"s"}}, same_name_any{}, b,
+                                       same_name_any{1.5}, a, same_name_any{2L}, same_name_any{1}};
+    auto by_less      = v;
+    auto by_three_way = v;
+    std::sort(by_less.begin(), by_less.end(), less);
+    std::sort(by_three_way.begin(), by_three_way.end(), [](const auto& x, const auto& y) { return (x <=> y) < 0; });
+    for (size_t i{0}; i < v.size(); ++i)
+    {
+        EXPECT_EQ(by_less[i].properties(), by_three_way[i].properties());
+        EXPECT_EQ(by_less[i] <=> by_three_way[i], std::weak_ordering::equivalent);
+    }
+    EXPECT_TRUE(less(same_name_any{2L}, 3L));
+    EXPECT_EQ(less(same_name_any{2L}, 3), (same_name_any{2L} <=> same_name_any{3}) < 0);  // a plain key alike
+}
+
+namespace {
+enum class color : int8_t
+{
+    red = -1,
+    green,
+};
+struct point
+{
+    int32_t x;
+    int32_t y;
+    friend bool operator==(const point&, const point&) = default;
+};
+}  // namespace
+template<>
+struct ext::is_bitwise_comparable<point> : std::true_type
+{
+};
+
+TEST(TestAny, BitwiseEqAndHash)
+{
+    using AT = ext::any<16, ext::af_strict_eq, ext::af_strict_hash>;
+    using eq = ext::af_strict_eq<AT>;
+    using hs = ext::af_strict_hash<AT>;
+    using PT = ext::any<16, ext::af_strict_eq>;
+    const PT p12{point{1, 2}};
+    const PT p21{point{2, 1}};
+
+    EXPECT_EQ(AT{1}.properties()->_strict_eq, &eq::bitwise_eq_value<4>);
+    EXPECT_EQ(AT{uint64_t{1}}.properties()->_strict_eq, &eq::bitwise_eq_value<8>);
+    EXPECT_EQ(AT{color::red}.properties()->_strict_eq, &eq::bitwise_eq_value<1>);
+    EXPECT_EQ(p12.properties()->_strict_eq, &ext::af_strict_eq<PT>::bitwise_eq_value<8>);
+    EXPECT_NE(AT{1.0}.properties()->_strict_eq, &eq::bitwise_eq_value<8>);  // 0.0 == -0.0
+
+    EXPECT_TRUE(AT{7} == AT{7});
+    EXPECT_FALSE(AT{7} == AT{-7});
+    EXPECT_TRUE(AT{color::red} == AT{color::red});
+    EXPECT_FALSE(AT{color::red} == AT{color::green});
+    EXPECT_TRUE(p12 == PT{p12});
+    EXPECT_FALSE(p12 == p21);
+    EXPECT_TRUE(AT{0.0} == AT{-0.0});
+
+    // the inline hash is the std::hash of the value.
+    EXPECT_EQ((AT{-7}.properties()->_strict_hash), (&hs::identity_hash_value<4, true>));
+    EXPECT_EQ(AT{-7}.get_hash(), std::hash<int>{}(-7));
+    EXPECT_EQ(AT{~uint32_t{0}}.get_hash(), std::hash<uint32_t>{}(~uint32_t{0}));
+    EXPECT_EQ(AT{int64_t{-3}}.get_hash(), std::hash<int64_t>{}(-3));
+    EXPECT_EQ(AT{color::red}.get_hash(), std::hash<color>{}(color::red));
+    EXPECT_EQ(AT{'x'}.get_hash(), std::hash<char>{}('x'));
+
+    using MT = ext::any<16, ext::af_strict_hash, ext::af_mixed_hash>;
+    EXPECT_NE(MT{1}.get_hash(), std::hash<int>{}(1));
+}
+
+#if defined(__cpp_lib_format)
+TEST(TestAny, Formatted)
+{
+    struct opaque
+    {
+        int x;
+    };
+    using AT = ext::any<16, ext::af_formatted>;
+    EXPECT_EQ(std::format("{}", AT{42}), "42");
+    EXPECT_EQ(std::format("[{:>6}]", AT{std::string{"ab"}}), "[    ab]");
+    EXPECT_EQ(std::format("{:.3}|{:x}", AT{3.14159}, AT{255}), "3.14|ff");
+    EXPECT_EQ(std::format("[{}][{}]", AT{}, AT{opaque{1}}), "[][]");
+
+    char       buffer[32];
+    const auto end{std::format_to(buffer, "{:05}", AT{7})};
+    EXPECT_EQ(std::string_view(buffer, end), "00007");
+
+    using VT = ext::any<16, ext::af_variant<int, double>::template types, ext::af_formatted>;
+    EXPECT_EQ(std::format("{:+} {:.1f}", VT{7}, VT{2.5}), "+7 2.5");
+
+    // the width or precision of a nested replacement field is not known to the formatter of the stored type.
+    const AT  value{42};
+    const int width{5};
+    EXPECT_THROW((void)std::vformat("{:{}}", std::make_format_args(value, width)), std::format_error);
+    EXPECT_THROW((void)std::vformat("{0:{1}}", std::make_format_args(value, width)), std::format_error);
+    EXPECT_THROW((void)std::vformat("{:.{}}", std::make_format_args(value, width)), std::format_error);
+}
+#endif
+
+namespace {
+struct price
+{
+    int64_t ticks;
+};
+std::to_chars_result to_chars(char* first, char* last, const price& p)
+{
+    const auto r{std::to_chars(first, last, p.ticks / 100)};
+    if (r.ec != std::errc{} || last - r.ptr < 3) return {last, std::errc::value_too_large};
+    r.ptr[0] = '.';
+    r.ptr[1] = static_cast<char>('0' + p.ticks / 10 % 10);
+    r.ptr[2] = static_cast<char>('0' + p.ticks % 10);
+    return {r.ptr + 3, std::errc{}};
+}
+}  // namespace
+
+TEST(TestAny, ToChars)
+{
+    using AT = ext::any<16, ext::af_to_chars>;
+    char       buffer[64];
+    const auto text = [&](const AT& a) {
+        const auto r{to_chars(std::begin(buffer), std::end(buffer), a)};
+        EXPECT_EQ(r.ec, std::errc{});
+        return std::string(buffer, r.ptr);
+    };
+    EXPECT_EQ(text(AT{-42}), "-42");
+    EXPECT_EQ(text(AT{uint64_t{18446744073709551615ULL}}), "18446744073709551615");
+    EXPECT_EQ(text(AT{0.1}), "0.1");
+    EXPECT_EQ(text(AT{true}), "true");
+    EXPECT_EQ(text(AT{'x'}), "x");
+    EXPECT_EQ(text(AT{std::string{"abc"}}), "abc");
+    EXPECT_EQ(text(AT{"literal"}), "literal");
+    EXPECT_EQ(text(AT{price{12345}}), "123.45");
+    EXPECT_EQ(text(AT{}), "");
+
+    struct opaque
+    {
+    };
+    EXPECT_EQ(to_chars(std::begin(buffer), std::end(buffer), AT{opaque{}}).ec, std::errc::invalid_argument);
+    EXPECT_EQ(to_chars(buffer, buffer + 2, AT{12345}).ec, std::errc::value_too_large);
+    EXPECT_EQ(to_chars(buffer, buffer + 2, AT{std::string{"abc"}}).ec, std::errc::value_too_large);
+
+    using VT = ext::any<16, ext::af_variant<int, double>::template types, ext::af_to_chars>;
+    const auto r{to_chars(std::begin(buffer), std::end(buffer), VT{2.5})};
+    EXPECT_EQ(std::string(buffer, r.ptr), "2.5");
+}
+
+TEST(TestAny, TypeFingerprint)
+{
+    static_assert(ext::type_fingerprint<int>() != ext::type_fingerprint<long>());
+    static_assert(ext::type_fingerprint<int>() == ext::type_fingerprint<int>());
+    static_assert(ext::type_fingerprint<std::string>() != 0);
+
+    using AT = ext::any<16>;
+    EXPECT_EQ(AT{}.fingerprint(), 0U);
+    EXPECT_EQ(AT{1}.fingerprint(), ext::type_fingerprint<int>());
+    EXPECT_EQ(AT{std::string{"s"}}.fingerprint(), ext::type_fingerprint<std::string>());
+
+    const auto kind = [](const AT& a) {
+        switch (a.fingerprint())
+        {
+        case 0: return "empty";
+        case ext::type_fingerprint<int>(): return "int";
+        case ext::type_fingerprint<double>(): return "double";
+        default: return "other";
+        }
+    };
+    EXPECT_STREQ(kind(AT{}), "empty");
+    EXPECT_STREQ(kind(AT{7}), "int");
+    EXPECT_STREQ(kind(AT{7.5}), "double");
+    EXPECT_STREQ(kind(AT{7L}), "other");
+    EXPECT_FALSE(AT{7L}.holds<int>());
+}
@@ -0,0 +1,21 @@
+// A second translation unit of ext_any_gtest: a type with the same name as a type of ext_any_gtest.cpp, in its own
+// anonymous namespace. The two types have the same src_type_name and type_fingerprint, and other layouts.
+
+#include <compare>
+#include <cstdint>
+#include <ext/any.h>
+
+namespace {
+struct key
+{
+    int64_t value;
+    friend auto operator<=>(const key&, const key&) = default;
+};
+}  // namespace
+
+using same_name_any = ext::any<16, ext::af_strict_less, ext::af_three_way>;
+
+same_name_any other_tu_key(int64_t value)
+{
+    return same_name_any{key{value}};
+}
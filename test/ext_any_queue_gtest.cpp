@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_queue.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct order
+{
+    int64_t id;
+    double  price;
+};
+
+struct throwing
+{
+    explicit throwing(int) { throw std::runtime_error("throwing"); }
+};
+
+using message = ext::any<48>;
+}  // namespace
+
+template<typename Q>
+class TestAnyQueue : public ::testing::Test
+{
+};
+using queue_types = ::testing::Types<ext::any_spsc_queue<message>, ext::any_mpmc_queue<message>>;
+TYPED_TEST_SUITE(TestAnyQueue, queue_types);
+
+TYPED_TEST(TestAnyQueue, EmplacePop)
+{
+    TypeParam q{3};
+    EXPECT_EQ(q.capacity(), 4U);
+
+    message out;
+    EXPECT_FALSE(q.try_pop(out));
+    EXPECT_TRUE(q.template try_emplace<order>(int64_t{1}, 10.5));
+    EXPECT_TRUE(q.template try_emplace<std::string>(std::string(100, 'x')));  // heap stored
+    EXPECT_TRUE(q.try_push(message{3}));
+    EXPECT_TRUE(q.try_push(message{}));
+    EXPECT_FALSE(q.try_push(message{5}));
+
+    ASSERT_TRUE(q.try_pop(out));
+    EXPECT_EQ(any_cast<order>(out).price, 10.5);
+    ASSERT_TRUE(q.try_pop(out));
+    EXPECT_EQ(any_cast<std::string>(out).size(), 100U);
+    ASSERT_TRUE(q.try_pop(out));
+    EXPECT_EQ(any_cast<int>(out), 3);
+    ASSERT_TRUE(q.try_pop(out));
+    EXPECT_FALSE(out.has_value());
+    EXPECT_FALSE(q.try_pop(out));
+
+    EXPECT_THROW(q.template try_emplace<throwing>(1), std::runtime_error);
+    if (q.try_pop(out))  // the mpmc queue had claimed the slot: an empty any
+    {
+        EXPECT_FALSE(out.has_value());
+    }
+    for (int i{0}; i < 10; ++i)  // wraps
+    {
+        q.template emplace<int>(i);
+        q.pop(out);
+        EXPECT_EQ(any_cast<int>(out), i);
+    }
+}
+
+TYPED_TEST(TestAnyQueue, Threads)
+{
+    TypeParam         q{64};
+    constexpr int64_t count{100000};
+    std::thread       producer{[&] {
+        for (int64_t i{0}; i < count; ++i)
+        {
+            if (i % 3) q.template emplace<int64_t>(i);
+            else q.push(message{std::to_string(i)});
+        }
+    }};
+    int64_t sum{0};
+    message out;
+    for (int64_t i{0}; i < count; ++i)
+    {
+        q.pop(out);
+        if (out.holds<int64_t>()) sum += any_cast<int64_t>(out);
+        else if (out.holds<std::string>()) sum += std::stoll(any_cast<std::string>(out));
+    }
+    producer.join();
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+}
+
+TEST(TestAnyMpmcQueue, ManyProducersConsumers)
+{
+    ext::any_mpmc_queue<message> q{128};
+    constexpr int64_t            per_producer{20000};
+    constexpr int                producers{4};
+    constexpr int                consumers{4};
+    std::atomic<int64_t>         sum{0};
+    std::atomic<int64_t>         popped{0};
+    std::vector<std::thread>     threads;
+    for (int p{0}; p < producers; ++p)
+    {
+        threads.emplace_back([&] {
+            for (int64_t i{0}; i < per_producer; ++i) q.template emplace<int64_t>(i);
+        });
+    }
+    for (int c{0}; c < consumers; ++c)
+    {
+        threads.emplace_back([&] {
+            message out;
+            while (popped.load() < producers * per_producer)
+            {
+                if (q.try_pop(out))
+                {
+                    sum += any_cast<int64_t>(out);
+                    ++popped;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum.load(), producers * per_producer * (per_producer - 1) / 2);
+}
+
+TEST(TestAnySpscQueue, ConsumeInPlace)
+{
+    ext::any_spsc_queue<message> q{8};
+    q.emplace<order>(int64_t{7}, 1.25);
+    int64_t id{0};
+    EXPECT_TRUE(q.try_consume([&](message& m) { id = any_cast<order>(m).id; }));
+    EXPECT_EQ(id, 7);
+    EXPECT_FALSE(q.try_consume([](message&) {}));
+}
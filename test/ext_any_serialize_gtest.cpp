@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_serialize.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct tick
+{
+    int64_t time;
+    double  price;
+    int32_t volume;
+};
+
+struct label
+{
+    std::string text;
+};
+
+struct named_tick  // trivially copyable, its bytes hold an address
+{
+    const char* name;
+    double      price;
+};
+
+enum class side : uint8_t
+{
+    buy,
+    sell
+};
+}  // namespace
+
+template<>
+struct ext::is_bitwise_serializable<tick> : std::true_type
+{
+};
+
+template<>
+struct ext::serializer<label>
+{
+    static size_t size(const label& l) noexcept { return l.text.size(); }
+    static void   write(std::byte* out, const label& l) noexcept { std::memcpy(out, l.text.data(), l.text.size()); }
+    static label  read(std::span<const std::byte> in)
+    {
+        return label{std::string(reinterpret_cast<const char*>(in.data()), in.size())};
+    }
+};
+
+using record_any = ext::any<16, ext::af_serialize>;
+
+TEST(TestAnySerialize, RecordRoundTrip)
+{
+    const record_any a{int32_t{-7}};
+    EXPECT_EQ(a.serialized_size(), 16U + 8U);
+
+    std::vector<std::byte> buffer(64);
+    EXPECT_EQ(a.serialize(std::span{buffer}.first(10)), 0U);  // too small
+    ASSERT_EQ(a.serialize(buffer), 24U);
+
+    ext::any_record_header header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    EXPECT_EQ(header.type_id, ext::type_fingerprint<int32_t>());
+    EXPECT_EQ(header.size, 4U);
+
+    ext::any_registry<record_any> registry;
+    registry.add<int32_t, double>();
+    EXPECT_TRUE(registry.contains<int32_t>());
+    EXPECT_FALSE(registry.contains<std::string>());
+
+    std::span<const std::byte> in{buffer.data(), 24};
+    const record_any           b{registry.read(in)};
+    EXPECT_TRUE(in.empty());
+    ASSERT_TRUE(b.holds<int32_t>());
+    EXPECT_EQ(any_cast<int32_t>(b), -7);
+}
+
+TEST(TestAnySerialize, MixedStream)
+{
+    std::vector<record_any> values;
+    for (int i{0}; i < 50; ++i)
+    {
+        values.emplace_back(tick{i, i * 0.5, i * 10});
+        values.emplace_back(std::string(static_cast<size_t>(i), 'x'));
+        values.emplace_back(label{std::to_string(i * 7)});
+        values.emplace_back();
+        values.emplace_back(static_cast<uint8_t>(i));
+    }
+    std::vector<std::byte> buffer{std::byte{0xAB}};  // appended after existing content
+    ext::serialize_all(values, buffer);
+    EXPECT_EQ(buffer.size(), 1 + ext::serialized_size(values));
+
+    ext::any_registry<record_any> registry;
+    registry.add<tick, std::string, label, uint8_t>();
+    std::vector<record_any> replay;
+    EXPECT_EQ(registry.read_all(std::span{buffer}.subspan(1), replay), values.size());
+    ASSERT_EQ(replay.size(), values.size());
+    for (size_t i{0}; i < values.size(); i += 5)
+    {
+        const auto& t{any_cast<tick>(replay[i])};
+        EXPECT_EQ(t.time, any_cast<tick>(values[i]).time);
+        EXPECT_EQ(t.price, any_cast<tick>(values[i]).price);
+        EXPECT_EQ(any_cast<std::string>(replay[i + 1]), any_cast<std::string>(values[i + 1]));
+        EXPECT_EQ(any_cast<label>(replay[i + 2]).text, any_cast<label>(values[i + 2]).text);
+        EXPECT_FALSE(replay[i + 3].has_value());
+        EXPECT_EQ(any_cast<uint8_t>(replay[i + 4]), any_cast<uint8_t>(values[i + 4]));
+    }
+}
+
+TEST(TestAnySerialize, InvalidInput)
+{
+    std::vector<std::byte> buffer;
+    ext::serialize_all(std::vector<record_any>{record_any{1.5}}, buffer);
+
+    ext::any_registry<record_any> registry;
+    std::vector<record_any>       out;
+    EXPECT_THROW(registry.read_all(buffer, out), std::runtime_error);  // double not registered
+    EXPECT_TRUE(out.empty());
+    registry.add<double>();
+    EXPECT_THROW(registry.read_all(std::span{buffer}.first(20), out), std::runtime_error);  // truncated
+    EXPECT_TRUE(out.empty());
+
+    // the records read before the one that fails stay, nothing else is added.
+    std::vector<std::byte> stream;
+    ext::serialize_all(std::vector<record_any>{record_any{1}, record_any{}, record_any{1.5}}, stream);
+    ext::any_registry<record_any> int_registry;
+    int_registry.add<int>();
+    EXPECT_THROW(int_registry.read_all(stream, out), std::runtime_error);
+    ASSERT_EQ(out.size(), 2U);
+    EXPECT_EQ(any_cast<int>(out[0]), 1);
+    EXPECT_FALSE(out[1].has_value());
+    EXPECT_THROW(int_registry.read_all(std::span{stream}.first(stream.size() - 1), out), std::runtime_error);
+    EXPECT_EQ(out.size(), 4U);
+
+    ext::any_record_header header{ext::type_fingerprint<double>(), 3, 0};
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::span<const std::byte> in{buffer};
+    EXPECT_THROW((void)registry.read(in), std::runtime_error);  // wrong payload size
+}
+
+TEST(TestAnySerialize, BitwiseOptIn)
+{
+    // arithmetic and enum types are bitwise, a trivially copyable struct only once opted in.
+    static_assert(ext::is_bytewise_serialized_v<double>);
+    static_assert(ext::is_bytewise_serialized_v<side>);
+    static_assert(ext::is_bytewise_serialized_v<tick>);
+    static_assert(!ext::is_bytewise_serialized_v<label> && ext::is_serializable_v<label>);
+
+    // the bytes of a view or a pointer are an address, meaningless once read back: not serializable.
+    static_assert(std::is_trivially_copyable_v<std::string_view> && !ext::is_serializable_v<std::string_view>);
+    static_assert(std::is_trivially_copyable_v<std::span<const int>> && !ext::is_serializable_v<std::span<const int>>);
+    static_assert(std::is_trivially_copyable_v<named_tick> && !ext::is_serializable_v<named_tick>);
+    static_assert(!ext::is_serializable_v<const char*>);
+
+    ext::any_registry<record_any> registry;
+    registry.add<side>();
+    std::vector<std::byte> buffer;
+    ext::serialize_all(std::vector<record_any>{record_any{side::sell}}, buffer);
+    std::vector<record_any> values;
+    registry.read_all(buffer, values);
+    ASSERT_EQ(values.size(), 1U);
+    EXPECT_EQ(any_cast<side>(values[0]), side::sell);
+}
+
+TEST(TestAnySerialize, BoolIsChecked)
+{
+    // a bool is read from a byte checked to be 0 or 1, never from the raw byte.
+    static_assert(!ext::is_bitwise_serializable_v<bool> && !ext::is_bytewise_serialized_v<bool>);
+    static_assert(ext::is_serializable_v<bool>);
+
+    ext::any_registry<record_any> registry;
+    registry.add<bool>();
+    std::vector<std::byte> buffer;
+    ext::serialize_all(std::vector<record_any>{record_any{true}, record_any{false}}, buffer);
+    std::vector<record_any> values;
+    ASSERT_EQ(registry.read_all(buffer, values), 2U);
+    EXPECT_TRUE(any_cast<bool>(values[0]));
+    EXPECT_FALSE(any_cast<bool>(values[1]));
+
+    buffer[sizeof(ext::any_record_header)] = std::byte{2};
+    std::span<const std::byte> in{buffer};
+    EXPECT_THROW((void)registry.read(in), std::runtime_error);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <ext/any_shm.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+struct quote
+{
+    int64_t id;
+    double  bid;
+    double  ask;
+};
+}  // namespace
+
+template<>
+struct ext::is_bitwise_serializable<quote> : std::true_type
+{
+};
+
+namespace {
+using message = ext::any<16, ext::af_serialize>;
+
+ext::any_registry<message> make_registry()
+{
+    ext::any_registry<message> registry;
+    registry.add<quote, int64_t, std::string>();
+    return registry;
+}
+}  // namespace
+
+TEST(TestAnyShm, PushConsumeWrap)
+{
+    const auto       registry{make_registry()};
+    ext::shm_segment segment{ext::shm_segment::anonymous(ext::any_shm_ring<message>::segment_size(1024))};
+    auto             producer{ext::any_shm_ring<message>::create(segment.bytes(), registry)};
+    auto             consumer{ext::any_shm_ring<message>::attach(segment.bytes(), registry)};
+    EXPECT_EQ(producer.capacity(), 1024U);
+
+    message out;
+    EXPECT_FALSE(consumer.try_pop(out));
+    for (int64_t round{0}; round < 200; ++round)  // the records of a round do not divide the capacity: wraps
+    {
+        ASSERT_TRUE(producer.try_push(message{quote{round, 1.5, 2.5}}));
+        ASSERT_TRUE(producer.try_push(message{std::string(static_cast<size_t>(round % 50), 'x')}));
+        ASSERT_TRUE(producer.try_push(message{}));
+
+        ASSERT_TRUE(consumer.try_consume([&](const ext::any_record_ref<message>& r) {
+            ASSERT_TRUE(r.holds<quote>());
+            EXPECT_EQ(r.get<quote>().id, round);
+            EXPECT_EQ(r.src_type_name(), ext::src_type_name<quote>());
+        }));
+        ASSERT_TRUE(consumer.try_pop(out));
+        EXPECT_EQ(any_cast<std::string>(out).size(), static_cast<size_t>(round % 50));
+        ASSERT_TRUE(consumer.try_pop(out));
+        EXPECT_FALSE(out.has_value());
+    }
+    EXPECT_FALSE(consumer.try_pop(out));
+
+    size_t pushed{0};
+    while (producer.try_push(message{int64_t{7}})) ++pushed;
+    EXPECT_GE(pushed, 1024U / 24 - 1);  // less the end of the ring skipped by the wrap
+    EXPECT_LE(pushed, 1024U / 24);
+    EXPECT_THROW(producer.try_push(message{std::string(600, 'y')}), std::length_error);
+
+    std::byte not_a_ring[512]{};
+    EXPECT_THROW(ext::any_shm_ring<message>::attach(segment.bytes().subspan(64), registry), std::runtime_error);
+    EXPECT_THROW(ext::any_shm_ring<message>::create(std::span{not_a_ring}.subspan(1), registry),
+                 std::invalid_argument);
+}
+
+TEST(TestAnyShm, ReattachMidStream)
+{
+    // a side attached to a ring in use starts from the current positions, not from the creation.
+    const auto       registry{make_registry()};
+    ext::shm_segment segment{ext::shm_segment::anonymous(ext::any_shm_ring<message>::segment_size(256))};
+    {
+        auto    producer{ext::any_shm_ring<message>::create(segment.bytes(), registry)};
+        auto    consumer{ext::any_shm_ring<message>::attach(segment.bytes(), registry)};
+        message out;
+        for (int64_t i{0}; i < 50; ++i)
+        {
+            ASSERT_TRUE(producer.try_push(message{i}));
+            ASSERT_TRUE(consumer.try_pop(out));
+        }
+        ASSERT_TRUE(producer.try_push(message{int64_t{50}}));
+    }
+    auto    producer{ext::any_shm_ring<message>::attach(segment.bytes(), registry)};
+    auto    consumer{ext::any_shm_ring<message>::attach(segment.bytes(), registry)};
+    message out;
+    ASSERT_TRUE(consumer.try_pop(out));
+    EXPECT_EQ(any_cast<int64_t>(out), 50);
+    EXPECT_FALSE(consumer.try_pop(out));
+    for (int64_t i{51}; i < 100; ++i)
+    {
+        ASSERT_TRUE(producer.try_push(message{i}));
+        ASSERT_TRUE(consumer.try_pop(out));
+        EXPECT_EQ(any_cast<int64_t>(out), i);
+    }
+    EXPECT_FALSE(consumer.try_pop(out));
+}
+
+TEST(TestAnyShm, RecordOfAnUnknownType)
+{
+    // the consumer registry does not know quote: its records are dropped, not left blocking the ring.
+    const auto                 registry{make_registry()};
+    ext::any_registry<message> consumer_registry;
+    consumer_registry.add<int64_t>();
+    ext::shm_segment segment{ext::shm_segment::anonymous(ext::any_shm_ring<message>::segment_size(1024))};
+    auto             producer{ext::any_shm_ring<message>::create(segment.bytes(), registry)};
+    auto             consumer{ext::any_shm_ring<message>::attach(segment.bytes(), consumer_registry)};
+
+    ASSERT_TRUE(producer.try_push(message{quote{1, 1.5, 2.5}}));
+    ASSERT_TRUE(producer.try_push(message{int64_t{2}}));
+    ASSERT_TRUE(producer.try_push(message{quote{3, 1.5, 2.5}}));
+    ASSERT_TRUE(producer.try_push(message{int64_t{4}}));
+
+    message out;
+    EXPECT_THROW(consumer.try_pop(out), std::runtime_error);
+    ASSERT_TRUE(consumer.try_pop(out));
+    EXPECT_EQ(any_cast<int64_t>(out), 2);
+
+    // try_consume keeps the record its function throws on, skip() drops it.
+    const auto load{[](const ext::any_record_ref<message>& r) { (void)r.load(); }};
+    EXPECT_THROW(consumer.try_consume(load), std::runtime_error);
+    EXPECT_THROW(consumer.try_consume(load), std::runtime_error);
+    EXPECT_TRUE(consumer.skip());
+    ASSERT_TRUE(consumer.try_pop(out));
+    EXPECT_EQ(any_cast<int64_t>(out), 4);
+    EXPECT_FALSE(consumer.skip());
+    EXPECT_FALSE(consumer.try_pop(out));
+}
+
+TEST(TestAnyShm, Threads)
+{
+    const auto       registry{make_registry()};
+    ext::shm_segment segment{ext::shm_segment::anonymous(ext::any_shm_ring<message>::segment_size(4096))};
+    auto             producer{ext::any_shm_ring<message>::create(segment.bytes(), registry)};
+    auto             consumer{ext::any_shm_ring<message>::attach(segment.bytes(), registry)};
+
+    constexpr int64_t count{100000};
+    std::thread       writer{[&] {
+        for (int64_t i{0}; i < count; ++i)
+        {
+            const message m{i % 2 ? message{i} : message{std::to_string(i)}};
+            while (!producer.try_push(m)) std::this_thread::yield();
+        }
+    }};
+    int64_t sum{0};
+    for (int64_t i{0}; i < count;)
+    {
+        if (consumer.try_consume([&](const ext::any_record_ref<message>& r) {
+                if (const auto* n{r.get_if<int64_t>()}) sum += *n;
+                else sum += std::stoll(any_cast<std::string>(r.load()));
+            }))
+            ++i;
+    }
+    writer.join();
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+}
+
+TEST(TestAnyShm, NamedSegmentAcrossProcesses)
+{
+    const std::string name{"/ext_any_shm_gtest_" + std::to_string(::getpid())};
+    const auto        registry{make_registry()};
+    ext::shm_segment  segment{ext::shm_segment::create(name, ext::any_shm_ring<message>::segment_size(4096))};
+    auto              consumer{ext::any_shm_ring<message>::create(segment.bytes(), registry)};
+
+    const pid_t child{::fork()};
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        ext::shm_segment shared{ext::shm_segment::open(name)};
+        auto             producer{ext::any_shm_ring<message>::attach(shared.bytes(), registry)};
+        for (int64_t i{0}; i < 1000; ++i)
+        {
+            while (!producer.try_push(message{quote{i, 0.5, 1.5}})) std::this_thread::yield();
+        }
+        ::_exit(0);
+    }
+    int64_t next{0};
+    while (next < 1000)
+    {
+        consumer.try_consume([&](const ext::any_record_ref<message>& r) { EXPECT_EQ(r.get<quote>().id, next++); });
+    }
+    int status{0};
+    ::waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <ext/any_sorted.h>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using key_any = ext::any<16, ext::af_strict_less, ext::af_strict_eq>;
+using namespace std::string_view_literals;
+
+TEST(TestAnySorted, TotalOrderOnMixedTypes)
+{
+    const ext::any_less<key_any> less{};
+    const key_any                empty{};
+    const key_any                i1{1};
+    const key_any                i2{2};
+    const key_any                d1{1.0};
+    const key_any                s1{std::string{"a"}};
+
+    EXPECT_TRUE(less(empty, i1));
+    EXPECT_FALSE(less(i1, empty));
+    EXPECT_FALSE(less(empty, empty));
+    EXPECT_TRUE(less(i1, i2));
+    EXPECT_FALSE(less(i2, i1));
+    EXPECT_NE(less(i1, d1), less(d1, i1));  // a type order, one way or the other, no throw.
+    EXPECT_EQ(less(i2, d1), less(i1, d1));  // all the ints on the same side of the doubles.
+    EXPECT_NE(less(s1, d1), less(d1, s1));
+
+    EXPECT_TRUE(less(i1, 2));
+    EXPECT_FALSE(less(2, i2));
+    EXPECT_EQ(less(i1, 1.5), less(i1, d1));
+    EXPECT_TRUE(less(s1, "b"));
+    EXPECT_TRUE(less("0"sv, s1));
+}
+
+TEST(TestAnySorted, SetBulkBuildAndLookup)
+{
+    std::vector<key_any> values;
+    for (int i{99}; i >= 0; --i)
+    {
+        values.emplace_back(i);
+        values.emplace_back(std::to_string(i));
+        values.emplace_back(i);  // duplicate
+    }
+    values.emplace_back();
+
+    ext::any_sorted_set<key_any> set{std::move(values)};
+    EXPECT_EQ(set.size(), 201U);
+    EXPECT_FALSE(set[0].has_value());
+    EXPECT_TRUE(std::is_sorted(set.begin(), set.end(), ext::any_less<key_any>{}));
+
+    EXPECT_TRUE(set.contains(42));
+    EXPECT_TRUE(set.contains("42"));
+    EXPECT_TRUE(set.contains(key_any{}));
+    EXPECT_FALSE(set.contains(100));
+    EXPECT_FALSE(set.contains(42L));
+    EXPECT_EQ(set.find(7.5), set.end());
+    EXPECT_EQ(any_cast<int>(*set.find(5)), 5);
+
+    EXPECT_FALSE(set.insert(key_any{5}).second);
+    EXPECT_TRUE(set.insert(key_any{5.5}).second);
+    EXPECT_TRUE(set.contains(5.5));
+    EXPECT_EQ(set.erase(5.5), 1U);
+    EXPECT_EQ(set.erase(5.5), 0U);
+    EXPECT_EQ(set.size(), 201U);
+
+    const std::vector<key_any> probes{key_any{3}, key_any{std::string{"77"}}, key_any{1000}, key_any{0}, key_any{2.0},
+                                      key_any{}};
+    const auto                 found{set.find_n(probes)};
+    ASSERT_EQ(found.size(), probes.size());
+    EXPECT_EQ(found[5], 0U);
+    EXPECT_EQ(found[0], set.index_of(3));
+    EXPECT_EQ(found[1], set.index_of("77"sv));
+    EXPECT_EQ(found[2], set.npos);
+    EXPECT_EQ(found[3], set.index_of(0));
+    EXPECT_EQ(found[4], set.npos);
+
+    const std::vector<int> ints{50, 10, 500, 10};
+    const auto             int_found{set.find_n(ints)};
+    EXPECT_EQ(int_found[0], set.index_of(50));
+    EXPECT_EQ(int_found[1], set.index_of(10));
+    EXPECT_EQ(int_found[2], set.npos);
+    EXPECT_EQ(int_found[3], int_found[1]);
+
+    // the key positions are uint32_t: a larger range throws before anything is allocated or searched.
+    static constexpr int key{10};
+    const auto           huge{std::views::iota(uint64_t{0}, uint64_t{1} << 32) |
+                              std::views::transform([](uint64_t) -> const int& { return key; })};
+    EXPECT_THROW((void)set.find_n(huge), std::length_error);
+}
+
+TEST(TestAnySorted, MapBuildKeepsFirstAndLookup)
+{
+    std::vector<std::pair<key_any, std::string>> items;
+    items.emplace_back(key_any{2}, "two");
+    items.emplace_back(key_any{std::string{"x"}}, "ex");
+    items.emplace_back(key_any{1}, "one");
+    items.emplace_back(key_any{2}, "second two");
+
+    ext::any_sorted_map<key_any, std::string> map{std::move(items)};
+    EXPECT_EQ(map.size(), 3U);
+    EXPECT_EQ(map.at(2), "two");
+    EXPECT_EQ(map.at("x"sv), "ex");
+    EXPECT_EQ(map.find(3), nullptr);
+    EXPECT_THROW((void)map.at(3), std::out_of_range);
+
+    map[key_any{3}] = "three";
+    EXPECT_TRUE(map.try_emplace(key_any{0}, "zero").second);
+    EXPECT_FALSE(map.insert_or_assign(key_any{1}, "uno").second);
+    EXPECT_EQ(map.at(1), "uno");
+    EXPECT_EQ(map.erase(2), 1U);
+
+    std::string joined;
+    map.for_each([&](const key_any&, const std::string& v) { joined += v + ","; });
+    EXPECT_EQ(joined.substr(0, 15), "zero,uno,three,");
+    EXPECT_EQ(map.size(), 4U);
+}